@@ -0,0 +1,44 @@
+#pragma once
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace optiz::cg {
+
+    struct BackendOptions {
+        std::string m_CPU;       // "native" selects the host CPU and its features
+        std::string m_Features;  // e.g. "+avx2,-avx512f", appended to the CPU's features
+        llvm::Optional<llvm::Reloc::Model> m_RelocationModel;
+        llvm::Optional<llvm::CodeModel::Model> m_CodeModel;
+        llvm::OptimizationLevel m_OptimizationLevel = llvm::OptimizationLevel::O0;
+    };
+
+    llvm::Expected<std::unique_ptr<llvm::TargetMachine>> CreateTargetMachine(const BackendOptions& options);
+
+    // Runs the default new-PM pipeline for the requested optimization level, or
+    // the ThinLTO pre-link pipeline when the module is going to be emitted as
+    // ThinLTO bitcode.
+    void OptimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::OptimizationLevel level,
+                        bool thinLTOPreLink = false);
+
+    llvm::Error EmitObjectFile(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_pwrite_stream& out);
+
+    // Writes bitcode carrying a ThinLTO module summary, for a ThinLTO link step.
+    void EmitThinLTOBitcode(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_ostream& out);
+
+    // Splits the module into `jobs` partitions and optimizes and emits each one
+    // on its own thread, in its own LLVMContext. Returns one object per partition.
+    llvm::Expected<std::vector<llvm::SmallString<0>>> EmitObjectFilesParallel(llvm::Module& module, const BackendOptions& options,
+                                                                              unsigned jobs);
+
+    // Combines objects into a single relocatable object with the system linker (`ld -r`).
+    llvm::Error LinkObjectFiles(const std::vector<llvm::SmallString<0>>& objects, llvm::StringRef outputFile);
+
+}  // namespace optiz::cg
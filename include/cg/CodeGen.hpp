@@ -0,0 +1,59 @@
+#pragma once
+
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+#include <string>
+#include <vector>
+
+#include "fe/AST.hpp"
+
+namespace optiz::cg {
+
+    // Every top-level statement of a program is lowered into its own function
+    // (a "unit"), and `main` calls the units in order, printing their results.
+    // Keeping the units separate lets the JIT compile only the ones that run.
+    class CodeGen : public fe::ASTVisitor {
+        llvm::Module& m_Module;
+        llvm::IRBuilder<> m_Builder;
+        llvm::Value* m_Value;
+        std::unique_ptr<llvm::DIBuilder> m_DIBuilder;
+        llvm::DIFile* m_DIFile;
+        llvm::DIScope* m_DIScope;
+
+    public:
+        // Divisions are checked for division by zero and overflow at run time,
+        // unless their operands prove that the check cannot fail.
+        // With `debugInfo`, every instruction carries the SrcLocation of the
+        // node it was generated from, and units are described as DWARF functions.
+        explicit CodeGen(llvm::Module& module, bool debugInfo = false);
+
+        static std::string GetUnitName(size_t index);
+
+        // What a failed run-time check prints, the interpreter reports the same.
+        static std::string GetCheckFailureReport(const fe::SrcLocation& location, const std::string& message);
+
+        llvm::Function* GenerateUnit(const fe::GenericASTNode& node, size_t index);
+
+        // Completes the debug info, after the last unit. Generating a whole
+        // program does this on its own.
+        void FinalizeDebugInfo();
+
+    private:
+        void Visit(const fe::UnaryExprAST& node) override;
+        void Visit(const fe::BinaryExprAST& node) override;
+        void Visit(const fe::NumberExprAST& node) override;
+        void Visit(const fe::ProgramAST& node) override;
+        void Visit(const fe::ErrorAST& node) override;
+
+        void GenerateMain(const fe::ProgramAST& node, const std::vector<llvm::Function*>& units);
+        void GenerateDivisionChecks(const fe::BinaryExprAST& node, llvm::Value* lhs, llvm::Value* rhs);
+        void GenerateCheck(llvm::Value* failed, const fe::SrcLocation& location, const std::string& message);
+        llvm::Function* GetCheckFailureHandler();
+
+        llvm::DISubprogram* CreateDebugFunction(llvm::Function& function, const fe::SrcLocation& location);
+        void SetDebugLocation(const fe::SrcLocation& location);
+    };
+
+}  // namespace optiz::cg
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+
+namespace optiz::cg {
+
+    struct CacheStats {
+        unsigned m_Hits   = 0;
+        unsigned m_Misses = 0;
+    };
+
+    // On-disk cache of compiled objects. Entries are written to a temporary
+    // file and renamed into place, so several compiler processes can share one
+    // cache directory. Eviction is LRU by access time, bounded by a pruning
+    // policy (see llvm::parseCachePruningPolicy).
+    class CompilationCache {
+        std::string m_Directory;
+        llvm::FileCache m_Cache;
+        std::unique_ptr<llvm::MemoryBuffer> m_Entry;
+        CacheStats m_Stats;
+
+    public:
+        static llvm::Expected<std::unique_ptr<CompilationCache>> Create(llvm::StringRef directory);
+
+        // Returns the object cached under `key`, calling `compile` to produce
+        // (and store) it on a miss.
+        llvm::Expected<llvm::SmallString<0>> GetOrCompile(llvm::StringRef key,
+                                                           llvm::function_ref<llvm::Error(llvm::raw_pwrite_stream&)> compile);
+
+        llvm::Error Prune(llvm::StringRef policy);
+
+        const CacheStats& GetStats() const;
+
+    private:
+        explicit CompilationCache(std::string directory);
+    };
+
+}  // namespace optiz::cg
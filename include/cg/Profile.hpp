@@ -0,0 +1,40 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+
+#include <string>
+#include <vector>
+
+namespace optiz::cg {
+
+    // A function that is counted by --instrument. The hash identifies the
+    // source it was generated from, so a profile recorded for older source is
+    // recognized as stale instead of being applied to the wrong code.
+    struct ProfileUnit {
+        std::string m_Name;
+        std::string m_Hash;
+    };
+
+    struct ProfileRecord {
+        std::string m_Hash;
+        uint64_t m_EntryCount;
+    };
+
+    using Profile = llvm::StringMap<ProfileRecord>;
+
+    // Counts the entries of every unit in `units` and makes `main` write the
+    // counts to `profileFile` before it returns. Programs that exit early,
+    // e.g. through a failed division check, don't write a profile.
+    void InstrumentModule(llvm::Module& module, llvm::ArrayRef<ProfileUnit> units, llvm::StringRef profileFile);
+
+    llvm::Expected<Profile> ReadProfile(llvm::StringRef profileFile);
+
+    // Attaches the recorded entry counts and a profile summary to the module,
+    // so the optimizer can tell hot from cold functions. Returns the units
+    // whose profile is stale; they are left without a count.
+    std::vector<std::string> ApplyProfile(llvm::Module& module, llvm::ArrayRef<ProfileUnit> units, const Profile& profile);
+
+}  // namespace optiz::cg
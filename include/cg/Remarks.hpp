@@ -0,0 +1,42 @@
+#pragma once
+
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/Support/Regex.h>
+
+#include <memory>
+#include <string>
+
+#include "fe/Diagnostic.hpp"
+
+namespace optiz::cg {
+
+    struct RemarkFilters {
+        std::string m_Passed;    // -Rpass
+        std::string m_Missed;    // -Rpass-missed
+        std::string m_Analysis;  // -Rpass-analysis
+    };
+
+    // Reports the optimization remarks of passes that match the filters as
+    // diagnostics at their source location. Remarks carry the location of
+    // the instruction's debug info, so the module needs at least line tables.
+    class RemarkHandler : public llvm::DiagnosticHandler {
+        fe::DiagnosticEngine& m_DiagnosticEngine;
+        std::string m_File;
+        std::unique_ptr<llvm::Regex> m_Passed;
+        std::unique_ptr<llvm::Regex> m_Missed;
+        std::unique_ptr<llvm::Regex> m_Analysis;
+
+    public:
+        // Empty filters disable their kind of remark. Remarks are reported
+        // against `file`, the debug info only records its base name.
+        RemarkHandler(fe::DiagnosticEngine& diagnosticEngine, std::string file, const RemarkFilters& filters);
+
+        bool handleDiagnostics(const llvm::DiagnosticInfo& info) override;
+
+        bool isAnalysisRemarkEnabled(llvm::StringRef passName) const override;
+        bool isMissedOptRemarkEnabled(llvm::StringRef passName) const override;
+        bool isPassedOptRemarkEnabled(llvm::StringRef passName) const override;
+        bool isAnyRemarkEnabled() const override;
+    };
+
+}  // namespace optiz::cg
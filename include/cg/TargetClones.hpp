@@ -0,0 +1,21 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <string>
+
+namespace optiz::cg {
+
+    // Turns `function` into an ifunc whose resolver runs once at load time and
+    // picks, with the CPU model from libgcc/compiler-rt (`__cpu_model`), the
+    // highest-priority clone the host supports. Every entry of `targets` other
+    // than "default" is a clone compiled with that x86 feature added, e.g.
+    // "avx2" or "avx512f". The original body becomes `<name>.default` and is
+    // compiled for the target machine's own features, so it runs everywhere.
+    llvm::Error CreateTargetClones(llvm::Function& function, const llvm::TargetMachine& targetMachine,
+                                   llvm::ArrayRef<std::string> targets);
+
+}  // namespace optiz::cg
@@ -62,6 +62,8 @@ namespace optiz::fe {
 
         TokenType getOperation() const;
         const GenericASTNode* GetExpr() const;
+        // For passes that rewrite the tree in place.
+        std::unique_ptr<GenericASTNode>& GetMutableExpr();
     };
 
     class BinaryExprAST : public GenericASTNode {
@@ -76,6 +78,8 @@ namespace optiz::fe {
 
         const GenericASTNode* GetLHS() const;
         const GenericASTNode* GetRHS() const;
+        std::unique_ptr<GenericASTNode>& GetMutableLHS();
+        std::unique_ptr<GenericASTNode>& GetMutableRHS();
         TokenType GetOperation() const;
     };
 
@@ -87,6 +91,7 @@ namespace optiz::fe {
         SHARED_METHODS;
 
         const std::vector<std::unique_ptr<GenericASTNode>>& GetExpressions() const;
+        std::vector<std::unique_ptr<GenericASTNode>>& GetMutableExpressions();
     };
 
 }  // namespace optiz::fe
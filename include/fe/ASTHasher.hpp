@@ -0,0 +1,42 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/SHA1.h>
+
+#include "fe/ASTVisitor.hpp"
+
+namespace optiz::fe {
+
+    class GenericASTNode;
+
+    // Which source locations an ASTHasher includes. Generated code reports the
+    // location of a failed division check, and embeds every location in its
+    // debug info.
+    enum class HashedLocations {
+        None,
+        Divisions,
+        All
+    };
+
+    // Feeds a stable, structural description of an AST into a SHA1 hasher.
+    // Source locations are left out unless asked for, so moving code around
+    // does not change its hash.
+    class ASTHasher : public ASTVisitor {
+        llvm::SHA1& m_Hasher;
+        HashedLocations m_HashedLocations;
+
+    public:
+        explicit ASTHasher(llvm::SHA1& hasher, HashedLocations hashedLocations = HashedLocations::None);
+
+    private:
+        void Visit(const UnaryExprAST& node) override;
+        void Visit(const BinaryExprAST& node) override;
+        void Visit(const NumberExprAST& node) override;
+        void Visit(const ProgramAST& node) override;
+        void Visit(const ErrorAST& node) override;
+
+        void Update(uint32_t value);
+        void UpdateLocation(const GenericASTNode& node, bool isDivision = false);
+    };
+
+}  // namespace optiz::fe
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "fe/AST.hpp"
+
+namespace optiz::fe {
+
+    // Rewrites an AST in place with constant subexpressions evaluated and
+    // identities (x + 0, x - 0, x * 1, x / 1, +x, -(-x)) removed. Nodes that do
+    // not change are kept, only folded constants are allocated. Arithmetic wraps
+    // like the generated code does. Divisions by zero and INT_MIN / -1 are kept
+    // as they are, so they fail at run time exactly as before.
+    class ConstantFolder : public ASTVisitor {
+        std::unique_ptr<GenericASTNode> m_Result;  // the visited node on entry to Visit, what replaces it on exit
+        size_t m_FoldedNodes;
+        size_t m_SimplifiedNodes;
+
+    public:
+        ConstantFolder();
+
+        std::unique_ptr<GenericASTNode> Fold(std::unique_ptr<GenericASTNode> node);
+
+        // Nodes replaced by the value they evaluate to.
+        size_t GetFoldedNodeCount() const;
+        // Nodes removed by an identity.
+        size_t GetSimplifiedNodeCount() const;
+
+    private:
+        void Visit(const UnaryExprAST& node) override;
+        void Visit(const BinaryExprAST& node) override;
+        void Visit(const NumberExprAST& node) override;
+        void Visit(const ProgramAST& node) override;
+        void Visit(const ErrorAST& node) override;
+    };
+
+}  // namespace optiz::fe
@@ -23,13 +23,24 @@ namespace optiz::fe {
 
     class DiagnosticEngine {
         std::vector<Diagnostic> m_Reports;
+        size_t m_MaxErrors;
+        size_t m_ErrorCount  = 0;
         bool m_ErrorsOccured = false;
 
     public:
+        DiagnosticEngine();
+        // Aborts with a fatal error after `maxErrors` errors, 0 never does.
+        explicit DiagnosticEngine(size_t maxErrors);
+
         void Report(SrcLocation loc, std::string msg, DiagnosticLevel level);
         void Dump() const;
+        // Forgets the reports that were dumped, HasErrors() still remembers them.
+        void Clear();
+        // Starts over as if nothing had been reported.
+        void Reset();
         bool HasReports() const;
         bool HasErrors() const;
+        const std::vector<Diagnostic>& GetReports() const;
     };
 
 }  // namespace optiz::fe
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fe/AST.hpp"
+#include "fe/Diagnostic.hpp"
+
+namespace optiz::fe {
+
+    struct TextEdit {
+        uint m_Offset;
+        uint m_Length;  // number of bytes replaced
+        std::string m_Replacement;
+    };
+
+    // Keeps the AST of an edited buffer up to date. Top-level statements are
+    // the unit of reuse: an edit is re-lexed and re-parsed from the start of the
+    // statement it touches until the new token stream ends a statement exactly
+    // where an old one ended, and every other statement keeps its AST.
+    //
+    // Statements are kept in a balanced tree that only knows the extent of their
+    // text, not where it starts, so finding and replacing the edited statements
+    // costs O(log n) in the number of statements on top of re-parsing. The text
+    // is a plain string, so splicing an edit into it, and ReplaceText's search
+    // for the changed range, stay O(n) in the bytes of the file. Both run at
+    // memory speed, well under a millisecond for a 1.6 MiB file. Reused ASTs
+    // keep the locations they were parsed with, TranslateLocation maps those
+    // into the current text.
+    class IncrementalParser {
+        struct Statement {
+            SrcLocation m_ParsedStart;  // end of the previous statement when this one was parsed
+            SrcLocation m_ParsedEnd;
+            std::unique_ptr<GenericASTNode> m_Node;  // ErrorAST if the statement has syntax errors
+            bool m_HasDiagnostics;
+        };
+
+        class StatementTree;
+
+        std::string m_Text;
+        std::string m_File;
+        DiagnosticEngine m_DiagnosticEngine;
+        std::unique_ptr<StatementTree> m_Statements;
+        bool m_TailHasDiagnostics;  // text after the last statement, e.g. a stray character
+        size_t m_ReparsedCount;
+
+    public:
+        IncrementalParser(std::string text, std::string file);
+        ~IncrementalParser();
+
+        void ApplyEdit(const TextEdit& edit);
+        // Applies the edit that turns the current text into `text`: everything
+        // between their common prefix and common suffix is replaced.
+        void ReplaceText(const std::string& text);
+
+        // Only holds the diagnostics of the statements re-parsed by the last edit.
+        const DiagnosticEngine& GetDiagnostics() const;
+        // Whether any current statement reported diagnostics when it was parsed.
+        bool HasDiagnostics() const;
+
+        const std::string& GetText() const;
+        const std::string& GetFile() const;
+        size_t GetStatementCount() const;
+        const GenericASTNode& GetStatement(size_t index) const;
+        SrcLocation TranslateLocation(size_t index, const SrcLocation& location) const;
+
+        // A copy of the current AST with every location translated. Like
+        // Parser::ParseProgram, it leaves out statements with syntax errors.
+        // O(n) in the statements, like the code generation it is made for.
+        std::unique_ptr<ProgramAST> BuildProgram() const;
+
+        // Number of statements re-parsed by the last edit (or the initial parse).
+        size_t GetReparsedCount() const;
+
+    private:
+        SrcLocation GetCurrentEnd(size_t index) const;
+    };
+
+}  // namespace optiz::fe
@@ -2,6 +2,7 @@
 
 #include <ostream>
 #include <string>
+#include <string_view>
 
 #include "fe/Diagnostic.hpp"
 #include "fe/SrcLocation.hpp"
@@ -96,15 +97,18 @@ namespace optiz::fe {
         friend std::ostream& operator<<(std::ostream& out, const Token& token);
     };
 
+    // The input is not copied, it has to outlive the lexer.
     class Lexer {
-        std::string m_Input;
+        std::string_view m_Input;
         uint m_Cursor;
         SrcLocation m_Location;
         char m_Current;
         DiagnosticEngine& m_DiagnosticEngine;
 
     public:
-        Lexer(const std::string& input, const std::string& file, DiagnosticEngine& diagnosticEngine);
+        Lexer(std::string_view input, const std::string& file, DiagnosticEngine& diagnosticEngine);
+        // Starts lexing at `start.m_Offset`, which must be the start of a token or whitespace.
+        Lexer(std::string_view input, SrcLocation start, DiagnosticEngine& diagnosticEngine);
         Token GetNextToken();
 
     private:
@@ -112,6 +116,8 @@ namespace optiz::fe {
 
         void SkipWhitespace();
 
+        Token Tokenize();
+
         Token TokenizeNumber();
         Token TokenizeChar();
         Token TokenizeString();
@@ -10,16 +10,25 @@ namespace optiz::fe {
         DiagnosticEngine& m_DiagnosticEngine;
         Lexer m_Lexer;
         Token m_CurrentToken;
+        SrcLocation m_PreviousTokenEnd;
         bool m_PanicModeEnabled;
 
     public:
-        Parser(const std::string& input, const std::string& file, DiagnosticEngine& diagnosticEngine);
+        Parser(std::string_view input, const std::string& file, DiagnosticEngine& diagnosticEngine);
+        Parser(std::string_view input, SrcLocation start, DiagnosticEngine& diagnosticEngine);
         std::unique_ptr<GenericASTNode> ParseProgram();
 
+        // Parses a single `EXPRESSION ';'`. On a syntax error the rest of the
+        // statement is skipped and an ErrorAST is returned.
+        std::unique_ptr<GenericASTNode> ParseTopLevelStatement();
+        bool IsAtEnd() const;
+        const SrcLocation& GetPreviousTokenEnd() const;
+
     private:
         std::unique_ptr<GenericASTNode> ParseStatement();
         std::unique_ptr<GenericASTNode> ParseExpression();
         std::unique_ptr<GenericASTNode> ParseBinaryExpression();
+        std::unique_ptr<GenericASTNode> ParseBinaryOperationRHS(std::unique_ptr<GenericASTNode> lhs, int originalPrecedence);
         std::unique_ptr<GenericASTNode> ParseUnaryExpression();
         std::unique_ptr<GenericASTNode> ParsePrimaryExpression();
         std::unique_ptr<void> ParseSuffix();
@@ -37,11 +46,6 @@ namespace optiz::fe {
         std::unique_ptr<GenericASTNode> ParseStruct();
         std::unique_ptr<GenericASTNode> ParseAnnotationDef();
 
-        // std::unique_ptr<GenericASTNode> ParseExpression();
-        // std::unique_ptr<GenericASTNode> ParseUnary();
-        // std::unique_ptr<GenericASTNode> ParseBinOpRHS(std::unique_ptr<GenericASTNode> lhs, int operatorPrecedence);
-        // std::unique_ptr<GenericASTNode> ParsePrimary();
-
         void Advance();
         void Synchronize();
         void ReportError(SrcLocation loc, std::string msg);
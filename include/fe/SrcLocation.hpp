@@ -9,6 +9,7 @@ namespace optiz::fe {
         uint m_Line;
         uint m_Column;
         std::string m_File;
+        uint m_Offset = 0;
 
         friend std::ostream& operator<<(std::ostream& out, const SrcLocation& loc);
         friend class Lexer;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "fe/AST.hpp"
+#include "fe/Lexer.hpp"
+
+// Like LLVM's STATISTIC, the frontend counters only exist in builds with
+// assertions unless OPTIZ_FORCE_ENABLE_STATS is defined; otherwise every
+// OPTIZ_STAT(...) compiles to nothing.
+#if !defined(NDEBUG) || defined(OPTIZ_FORCE_ENABLE_STATS)
+#define OPTIZ_ENABLE_STATS    1
+#define OPTIZ_STAT(statement) statement
+#else
+#define OPTIZ_ENABLE_STATS    0
+#define OPTIZ_STAT(statement) ((void)0)
+#endif
+
+#define TOKEN_TYPE_COUNT (static_cast<size_t>(optiz::fe::TokenType::EndOfFile) + 1)
+#define NODE_KIND_COUNT  (static_cast<size_t>(optiz::fe::NodeKind::ProgramAST) + 1)
+
+namespace optiz::fe {
+
+    struct FrontendStatistics {
+        uint64_t m_Tokens[TOKEN_TYPE_COUNT]   = {};
+        uint64_t m_LexemeBytes                = 0;  // characters, wherever they are stored
+        uint64_t m_LexemeHeapBytes            = 0;  // lexemes too long for the small string buffer
+        uint64_t m_Nodes[NODE_KIND_COUNT]     = {};  // allocations, including nodes freed again (e.g. folded away)
+        uint64_t m_NodeBytes[NODE_KIND_COUNT] = {};
+        uint64_t m_FileNameCopies             = 0;  // SrcLocation::m_File in tokens and nodes
+        uint64_t m_FileNameHeapBytes          = 0;
+        uint64_t m_FoldedNodes                = 0;
+        uint64_t m_SimplifiedNodes            = 0;
+        uint64_t m_Diagnostics                = 0;
+        uint64_t m_DiagnosticBytes            = 0;
+    };
+
+    // The counters are process-wide and not synchronized; the frontend runs
+    // on a single thread.
+    FrontendStatistics& GetFrontendStatistics();
+
+    void CountToken(const Token& token);
+    void CountNode(const GenericASTNode& node, size_t size);
+    void CountDiagnostic(const Diagnostic& diagnostic);
+
+    // Heap memory owned by `string`, 0 when it fits in the small string buffer.
+    size_t GetHeapBytes(const std::string& string);
+
+    void PrintFrontendStatistics(std::ostream& out);
+
+}  // namespace optiz::fe
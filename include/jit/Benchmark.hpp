@@ -0,0 +1,47 @@
+#pragma once
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace optiz::jit {
+
+    using UnitFunction = int (*)();
+
+    struct BenchmarkOptions {
+        std::chrono::nanoseconds m_WarmupTime = std::chrono::milliseconds(100);
+        std::chrono::nanoseconds m_SampleTime = std::chrono::milliseconds(10);
+        unsigned m_Samples                    = 20;  // at least 2, for a standard deviation
+    };
+
+    // Per call, averaged over all samples. Counters the kernel refuses to open
+    // (no perf_event_open in containers, restrictive perf_event_paranoid, or
+    // no PMU in a VM) are left empty.
+    struct HardwareCounters {
+        llvm::Optional<double> m_Cycles;
+        llvm::Optional<double> m_Instructions;
+        llvm::Optional<double> m_CacheMisses;
+        llvm::Optional<double> m_BranchMisses;
+    };
+
+    struct BenchmarkResult {
+        std::string m_Name;
+        uint64_t m_Iterations;  // per sample
+        unsigned m_Samples;
+        double m_MeanNanoseconds;
+        double m_StdDevNanoseconds;
+        double m_MinNanoseconds;
+        HardwareCounters m_Counters;
+    };
+
+    // Warms `function` up, calibrates the iterations so one sample takes
+    // about the sample time, then measures the samples.
+    BenchmarkResult RunBenchmark(const std::string& name, UnitFunction function, const BenchmarkOptions& options);
+
+    void PrintBenchmarkResults(const std::vector<BenchmarkResult>& results, llvm::raw_ostream& out);
+    void PrintBenchmarkResultsJSON(const std::vector<BenchmarkResult>& results, llvm::raw_ostream& out);
+
+}  // namespace optiz::jit
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "jit/PerfMapListener.hpp"
+
+namespace optiz::jit {
+
+    struct CompileStats {
+        std::atomic<uint64_t> m_Nanoseconds = 0;
+        std::atomic<uint64_t> m_Functions   = 0;
+    };
+
+    // Lazily compiling JIT: functions are only compiled the first time they are
+    // called, so startup cost follows the code that actually runs.
+    class JIT {
+        // declared first, the JIT's object layer holds on to it
+        std::unique_ptr<PerfMapListener> m_PerfMapListener;
+        std::unique_ptr<llvm::orc::LLLazyJIT> m_JIT;
+        std::shared_ptr<CompileStats> m_CompileStats;
+
+    public:
+        // With `perfSupport`, compiled functions are published for `perf` in
+        // /tmp/perf-<pid>.map and in a jitdump (see `perf inject --jit`).
+        static llvm::Expected<std::unique_ptr<JIT>> Create(bool perfSupport = false);
+
+        llvm::Error AddLazyModule(llvm::orc::ThreadSafeModule module);
+        llvm::Error AddModule(llvm::orc::ThreadSafeModule module);
+        llvm::Expected<llvm::JITTargetAddress> Lookup(llvm::StringRef name);
+        llvm::Expected<int> RunMain();
+
+        std::chrono::nanoseconds GetCompileTime() const;
+        uint64_t GetCompiledFunctionCount() const;
+
+    private:
+        JIT(std::unique_ptr<PerfMapListener> perfMapListener, std::unique_ptr<llvm::orc::LLLazyJIT> jit,
+            std::shared_ptr<CompileStats> compileStats);
+    };
+
+}  // namespace optiz::jit
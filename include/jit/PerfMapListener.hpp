@@ -0,0 +1,26 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <mutex>
+
+namespace optiz::jit {
+
+    // Appends every JIT-compiled function to /tmp/perf-<pid>.map, the file
+    // `perf report` reads to name samples in anonymous executable memory.
+    // The map has no line numbers, those come from the jitdump written by
+    // LLVM's PerfJITEventListener when the code has debug info.
+    class PerfMapListener : public llvm::JITEventListener {
+        std::unique_ptr<llvm::raw_fd_ostream> m_Out;
+        std::mutex m_Mutex;
+
+    public:
+        PerfMapListener();
+
+        void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object,
+                                const llvm::RuntimeDyld::LoadedObjectInfo& info) override;
+    };
+
+}  // namespace optiz::jit
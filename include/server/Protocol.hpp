@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Wire protocol between optiz-client and `optiz --serve`, over a Unix domain
+// socket. Kept free of LLVM so the client stays small and starts instantly.
+//
+// Request:  uint32 payload size, sent together with the client's stdin, stdout
+//           and stderr (SCM_RIGHTS), then the payload: the client's working
+//           directory followed by the compiler arguments, each NUL-terminated.
+//           Payloads over 2 MiB are rejected.
+// Response: int32 exit code of the compilation.
+namespace optiz::server {
+
+    bool SendRequest(int socket, const std::vector<std::string>& payload);
+    bool ReceiveRequest(int socket, std::vector<std::string>& payload, int fds[3]);
+
+    bool WriteAll(int fd, const void* data, size_t size);
+    bool ReadAll(int fd, void* data, size_t size);
+
+}  // namespace optiz::server
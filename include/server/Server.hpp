@@ -0,0 +1,26 @@
+#pragma once
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <string>
+
+namespace optiz::server {
+
+    // Runs in the request's process. It may leave a short note about what it
+    // did in `warmUpNote`, for the server to prepare the next requests with.
+    using CompileFunction = llvm::function_ref<int(int argc, const char** argv, std::string& warmUpNote)>;
+
+    // Runs in the server between requests, with the note of a finished request.
+    // Whatever it keeps is inherited by every request forked after it.
+    using WarmUpFunction = llvm::function_ref<void(llvm::StringRef warmUpNote)>;
+
+    // Listens on a Unix domain socket and runs one compilation per request.
+    // Every request is handled in a process forked from the already initialized
+    // server, so it starts warm and cannot take the server down when it exits
+    // on an error. That process also reads the request, so a slow client only
+    // delays its own request. Requests compile concurrently, the server answers
+    // each one when its process exits. Only returns if the socket cannot be set up.
+    int Serve(llvm::StringRef socketPath, CompileFunction compile, WarmUpFunction warmUp);
+
+}  // namespace optiz::server
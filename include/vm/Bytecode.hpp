@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "fe/SrcLocation.hpp"
+
+namespace optiz::vm {
+
+    enum class OpCode : uint8_t {
+        LoadConst,  // dst = constants[lhs]
+        Neg,        // dst = -lhs
+        Add,        // dst = lhs + rhs
+        Sub,        // dst = lhs - rhs
+        Mul,        // dst = lhs * rhs
+        Div,        // dst = lhs / rhs
+        Ret,        // return dst
+    };
+
+    // Register-based, fixed-width (8 byte) instruction. Operands are register
+    // indices, except for LoadConst where `m_LHS` indexes the constant pool.
+    struct Instruction {
+        OpCode m_OpCode;
+        uint16_t m_Dst;
+        uint16_t m_LHS;
+        uint16_t m_RHS;
+    };
+
+    struct BytecodeFunction {
+        std::string m_Name;
+        std::vector<Instruction> m_Code;
+        std::vector<int32_t> m_Constants;
+        std::vector<std::pair<uint32_t, fe::SrcLocation>> m_Locations;  // of the instructions that can fail, by index
+        uint16_t m_RegisterCount;
+    };
+
+    struct BytecodeModule {
+        std::vector<BytecodeFunction> m_Functions;
+    };
+
+    std::ostream& operator<<(std::ostream& out, OpCode opCode);
+    std::ostream& operator<<(std::ostream& out, const BytecodeModule& module);
+
+}  // namespace optiz::vm
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "fe/AST.hpp"
+#include "vm/Bytecode.hpp"
+
+namespace optiz::vm {
+
+    // Compiles every top-level statement into a BytecodeFunction, mirroring the
+    // units generated by cg::CodeGen. Registers are allocated like a stack, so a
+    // function needs as many registers as its deepest expression.
+    class BytecodeCompiler : public fe::ASTVisitor {
+        BytecodeModule m_Module;
+        BytecodeFunction* m_Function;
+        uint16_t m_NextRegister;
+        uint16_t m_Result;
+
+    public:
+        BytecodeCompiler();
+
+        BytecodeModule TakeModule();
+
+    private:
+        void Visit(const fe::UnaryExprAST& node) override;
+        void Visit(const fe::BinaryExprAST& node) override;
+        void Visit(const fe::NumberExprAST& node) override;
+        void Visit(const fe::ProgramAST& node) override;
+        void Visit(const fe::ErrorAST& node) override;
+
+        uint16_t AllocateRegister();
+        void Emit(OpCode opCode, uint16_t dst, uint16_t lhs = 0, uint16_t rhs = 0);
+    };
+
+}  // namespace optiz::vm
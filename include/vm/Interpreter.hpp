@@ -0,0 +1,40 @@
+#pragma once
+
+#include <llvm/Support/Error.h>
+
+#include <memory>
+#include <vector>
+
+#include "vm/Bytecode.hpp"
+#include "vm/JITPromoter.hpp"
+
+namespace optiz::vm {
+
+    // Executes bytecode units and counts their calls. Once a unit has been
+    // called `promotionThreshold` times it is handed to the JITPromoter, and
+    // later calls go straight to the native code as soon as it is ready. Both
+    // fail the same way on a division by zero or overflow.
+    class Interpreter {
+        const BytecodeModule& m_Module;
+        std::unique_ptr<JITPromoter> m_Promoter;
+        std::vector<uint32_t> m_CallCounts;
+        uint32_t m_PromotionThreshold;
+        uint64_t m_InterpretedCalls;
+        uint64_t m_NativeCalls;
+
+    public:
+        // A threshold of 0 disables promotion.
+        Interpreter(const BytecodeModule& module, std::unique_ptr<JITPromoter> promoter, uint32_t promotionThreshold);
+
+        llvm::Expected<int32_t> Call(size_t index);
+        // Runs the units in order and prints their results, `runs` times over.
+        llvm::Error RunMain(uint32_t runs = 1);
+
+        uint64_t GetInterpretedCallCount() const;
+        uint64_t GetNativeCallCount() const;
+
+    private:
+        static llvm::Expected<int32_t> Execute(const BytecodeFunction& function);
+    };
+
+}  // namespace optiz::vm
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cg/Backend.hpp"
+#include "fe/AST.hpp"
+#include "jit/JIT.hpp"
+
+namespace optiz::vm {
+
+    using NativeFunction = int32_t (*)();
+
+    // Compiles hot units to native code on a background thread, optimized at
+    // the level in `options`. The JIT itself is only created once the first
+    // unit gets hot, so short scripts never pay for LLVM's initialization.
+    class JITPromoter {
+        const fe::ProgramAST& m_Program;
+        cg::BackendOptions m_Options;
+        std::unique_ptr<jit::JIT> m_JIT;
+        std::unique_ptr<llvm::TargetMachine> m_TargetMachine;
+        std::vector<std::atomic<NativeFunction>> m_NativeFunctions;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::deque<size_t> m_Queue;
+        bool m_Stopping;
+        std::thread m_Worker;
+
+    public:
+        JITPromoter(const fe::ProgramAST& program, cg::BackendOptions options);
+        ~JITPromoter();
+
+        void Request(size_t index);
+
+        NativeFunction GetNativeFunction(size_t index) const {
+            return m_NativeFunctions[index].load(std::memory_order_acquire);
+        }
+
+    private:
+        void Work();
+        llvm::Expected<NativeFunction> Compile(size_t index);
+    };
+
+}  // namespace optiz::vm
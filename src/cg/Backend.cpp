@@ -0,0 +1,277 @@
+#include "cg/Backend.hpp"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Transforms/IPO/ThinLTOBitcodeWriter.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+#include <functional>
+#include <mutex>
+
+static void addHostFeatures(llvm::SubtargetFeatures& features);
+static void runPipeline(llvm::Module& module, llvm::TargetMachine& targetMachine,
+                        const std::function<llvm::ModulePassManager(llvm::PassBuilder&)>& buildPipeline);
+static void registerTimeTraceCallbacks(llvm::PassInstrumentationCallbacks& callbacks);
+static std::string getIRName(llvm::Any ir);
+
+namespace optiz::cg {
+
+    llvm::Expected<std::unique_ptr<llvm::TargetMachine>> CreateTargetMachine(const BackendOptions& options) {
+        std::string triple = llvm::sys::getDefaultTargetTriple();
+        std::string error;
+
+        const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+        if (!target) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), error);
+        }
+
+        std::string cpu = options.m_CPU;
+        llvm::SubtargetFeatures features;
+
+        if (cpu == "native") {
+            cpu = llvm::sys::getHostCPUName().str();
+            addHostFeatures(features);
+        }
+
+        // explicit features come last so they can override the host's
+        if (!options.m_Features.empty()) {
+            llvm::SubtargetFeatures explicitFeatures(options.m_Features);
+
+            for (const std::string& feature : explicitFeatures.getFeatures()) {
+                features.AddFeature(feature);
+            }
+        }
+
+        llvm::CodeGenOpt::Level codeGenLevel = llvm::CodeGenOpt::None;
+        switch (options.m_OptimizationLevel.getSpeedupLevel()) {
+            case 0: codeGenLevel = llvm::CodeGenOpt::None; break;
+            case 1: codeGenLevel = llvm::CodeGenOpt::Less; break;
+            case 2: codeGenLevel = llvm::CodeGenOpt::Default; break;
+            default: codeGenLevel = llvm::CodeGenOpt::Aggressive; break;
+        }
+
+        llvm::TargetOptions targetOptions;
+        std::unique_ptr<llvm::TargetMachine> targetMachine(target->createTargetMachine(
+            triple, cpu, features.getString(), targetOptions, options.m_RelocationModel, options.m_CodeModel, codeGenLevel));
+
+        if (!targetMachine) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "cannot create a target machine for " + triple);
+        }
+
+        return targetMachine;
+    }
+
+    void OptimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::OptimizationLevel level,
+                        bool thinLTOPreLink) {
+        llvm::TimeTraceScope scope("Optimize", module.getName());
+
+        runPipeline(module, targetMachine, [&](llvm::PassBuilder& passBuilder) {
+            if (thinLTOPreLink) {
+                return passBuilder.buildThinLTOPreLinkDefaultPipeline(level);
+            }
+
+            return level == llvm::OptimizationLevel::O0
+                       ? passBuilder.buildO0DefaultPipeline(level)
+                       : passBuilder.buildPerModuleDefaultPipeline(level);
+        });
+    }
+
+    llvm::Error EmitObjectFile(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_pwrite_stream& out) {
+        llvm::TimeTraceScope scope("EmitObject", module.getName());
+
+        llvm::legacy::PassManager passManager;
+
+        if (targetMachine.addPassesToEmitFile(passManager, out, nullptr, llvm::CGFT_ObjectFile)) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "target cannot emit object files");
+        }
+
+        passManager.run(module);
+        return llvm::Error::success();
+    }
+
+    void EmitThinLTOBitcode(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_ostream& out) {
+        llvm::TimeTraceScope scope("EmitThinLTOBitcode", module.getName());
+
+        runPipeline(module, targetMachine, [&](llvm::PassBuilder&) {
+            llvm::ModulePassManager passManager;
+            passManager.addPass(llvm::ThinLTOBitcodeWriterPass(out, nullptr));
+            return passManager;
+        });
+    }
+
+    llvm::Expected<std::vector<llvm::SmallString<0>>> EmitObjectFilesParallel(llvm::Module& module, const BackendOptions& options,
+                                                                              unsigned jobs) {
+        // the worker threads are not traced, this scope covers their wall time
+        llvm::TimeTraceScope scope("EmitObjectFilesParallel");
+
+        // Partitions are handed over as bitcode so every thread can parse them
+        // into a private LLVMContext; contexts are not thread-safe.
+        std::vector<llvm::SmallString<0>> partitions;
+
+        llvm::SplitModule(module, jobs, [&partitions](std::unique_ptr<llvm::Module> partition) {
+            llvm::SmallString<0> bitcode;
+            llvm::raw_svector_ostream out(bitcode);
+            llvm::WriteBitcodeToFile(*partition, out);
+            partitions.push_back(std::move(bitcode));
+        });
+
+        std::vector<llvm::SmallString<0>> objects(partitions.size());
+        llvm::Error error = llvm::Error::success();
+        std::mutex errorMutex;
+
+        llvm::ThreadPool threadPool(llvm::hardware_concurrency(jobs));
+
+        for (size_t i = 0; i < partitions.size(); i++) {
+            threadPool.async([&, i] {
+                auto emitPartition = [&]() -> llvm::Error {
+                    llvm::LLVMContext context;
+
+                    auto partition = llvm::parseBitcodeFile(llvm::MemoryBufferRef(partitions[i], "partition"), context);
+                    if (!partition) {
+                        return partition.takeError();
+                    }
+
+                    auto targetMachine = CreateTargetMachine(options);
+                    if (!targetMachine) {
+                        return targetMachine.takeError();
+                    }
+
+                    OptimizeModule(**partition, **targetMachine, options.m_OptimizationLevel);
+
+                    llvm::raw_svector_ostream out(objects[i]);
+                    return EmitObjectFile(**partition, **targetMachine, out);
+                };
+
+                if (llvm::Error partitionError = emitPartition()) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    error = llvm::joinErrors(std::move(error), std::move(partitionError));
+                }
+            });
+        }
+
+        threadPool.wait();
+
+        if (error) {
+            return error;
+        }
+
+        return objects;
+    }
+
+    llvm::Error LinkObjectFiles(const std::vector<llvm::SmallString<0>>& objects, llvm::StringRef outputFile) {
+        llvm::TimeTraceScope scope("LinkObjectFiles");
+
+        auto linker = llvm::sys::findProgramByName("ld");
+        if (!linker) {
+            return llvm::createStringError(linker.getError(), "cannot find the system linker 'ld'");
+        }
+
+        std::vector<std::string> objectFiles;
+        llvm::Error error = llvm::Error::success();
+
+        for (const llvm::SmallString<0>& object : objects) {
+            llvm::SmallString<128> path;
+            int fd;
+
+            if (std::error_code ec = llvm::sys::fs::createTemporaryFile("optiz-part", "o", fd, path)) {
+                error = llvm::createStringError(ec, "cannot create a temporary object file");
+                break;
+            }
+
+            llvm::raw_fd_ostream out(fd, true);
+            out << object;
+            objectFiles.push_back(path.str().str());
+        }
+
+        if (!error) {
+            std::vector<llvm::StringRef> arguments = { *linker, "-r", "-o", outputFile };
+            arguments.insert(arguments.end(), objectFiles.begin(), objectFiles.end());
+
+            std::string message;
+            if (llvm::sys::ExecuteAndWait(*linker, arguments, llvm::None, {}, 0, 0, &message) != 0) {
+                error = llvm::createStringError(llvm::inconvertibleErrorCode(), "linking partitions failed: " + message);
+            }
+        }
+
+        for (const std::string& objectFile : objectFiles) {
+            llvm::sys::fs::remove(objectFile);
+        }
+
+        return error;
+    }
+
+}  // namespace optiz::cg
+
+static void addHostFeatures(llvm::SubtargetFeatures& features) {
+    llvm::StringMap<bool> hostFeatures;
+
+    if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+        for (const auto& feature : hostFeatures) {
+            features.AddFeature(feature.getKey(), feature.getValue());
+        }
+    }
+}
+
+static void runPipeline(llvm::Module& module, llvm::TargetMachine& targetMachine,
+                        const std::function<llvm::ModulePassManager(llvm::PassBuilder&)>& buildPipeline) {
+    llvm::LoopAnalysisManager loopAnalysisManager;
+    llvm::FunctionAnalysisManager functionAnalysisManager;
+    llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+    llvm::ModuleAnalysisManager moduleAnalysisManager;
+
+    // instrumentation is only registered when asked for, it is not free
+    llvm::PassInstrumentationCallbacks instrumentationCallbacks;
+    llvm::StandardInstrumentations standardInstrumentations(false);
+
+    if (llvm::TimePassesIsEnabled) {
+        standardInstrumentations.registerCallbacks(instrumentationCallbacks, &functionAnalysisManager);
+    }
+
+    if (llvm::timeTraceProfilerEnabled()) {
+        registerTimeTraceCallbacks(instrumentationCallbacks);
+    }
+
+    llvm::PassBuilder passBuilder(&targetMachine, llvm::PipelineTuningOptions(), llvm::None, &instrumentationCallbacks);
+    passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+    passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+    passBuilder.registerLoopAnalyses(loopAnalysisManager);
+    passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+    llvm::ModulePassManager passManager = buildPipeline(passBuilder);
+    passManager.run(module, moduleAnalysisManager);
+}
+
+static void registerTimeTraceCallbacks(llvm::PassInstrumentationCallbacks& callbacks) {
+    callbacks.registerBeforeNonSkippedPassCallback(
+        [](llvm::StringRef pass, llvm::Any ir) { llvm::timeTraceProfilerBegin(pass, getIRName(ir)); });
+    callbacks.registerAfterPassCallback(
+        [](llvm::StringRef, llvm::Any, const llvm::PreservedAnalyses&) { llvm::timeTraceProfilerEnd(); });
+    callbacks.registerAfterPassInvalidatedCallback(
+        [](llvm::StringRef, const llvm::PreservedAnalyses&) { llvm::timeTraceProfilerEnd(); });
+}
+
+static std::string getIRName(llvm::Any ir) {
+    if (llvm::any_isa<const llvm::Module*>(ir)) {
+        return llvm::any_cast<const llvm::Module*>(ir)->getName().str();
+    }
+
+    if (llvm::any_isa<const llvm::Function*>(ir)) {
+        return llvm::any_cast<const llvm::Function*>(ir)->getName().str();
+    }
+
+    return "";
+}
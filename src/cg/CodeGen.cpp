@@ -0,0 +1,252 @@
+#include "cg/CodeGen.hpp"
+
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "fe/AST.hpp"
+
+#define CHECK_FAILURE_HANDLER "optiz.check.fail"
+
+namespace optiz::cg {
+
+    CodeGen::CodeGen(llvm::Module& module, bool debugInfo)
+        : m_Module(module),
+          m_Builder(module.getContext()),
+          m_Value(nullptr),
+          m_DIFile(nullptr),
+          m_DIScope(nullptr) {
+        if (!debugInfo) {
+            return;
+        }
+
+        llvm::StringRef path = module.getSourceFileName();
+        llvm::SmallString<128> directory(llvm::sys::path::parent_path(path));
+        llvm::sys::fs::make_absolute(directory);
+
+        m_DIBuilder = std::make_unique<llvm::DIBuilder>(module);
+        m_DIFile    = m_DIBuilder->createFile(llvm::sys::path::filename(path), directory);
+        m_DIBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, m_DIFile, "optiz " OPTIZ_VERSION, false, "", 0);
+
+        if (!module.getModuleFlag("Debug Info Version")) {
+            module.addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+            module.addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+        }
+    }
+
+    std::string CodeGen::GetUnitName(size_t index) {
+        return "optiz.stmt." + std::to_string(index);
+    }
+
+    std::string CodeGen::GetCheckFailureReport(const fe::SrcLocation& location, const std::string& message) {
+        return location.m_File + ":" + std::to_string(location.m_Line) + ":" + std::to_string(location.m_Column) + ": error: " + message;
+    }
+
+    void CodeGen::Visit(const fe::UnaryExprAST& node) {
+        node.GetExpr()->accept(*this);
+        SetDebugLocation(node.GetStartLocation());
+
+        switch (node.getOperation()) {
+            case fe::TokenType::Plus: break;
+            case fe::TokenType::Minus: m_Value = m_Builder.CreateNeg(m_Value); break;
+            default: llvm_unreachable("unsupported unary operation");
+        }
+    }
+
+    void CodeGen::Visit(const fe::BinaryExprAST& node) {
+        node.GetLHS()->accept(*this);
+        llvm::Value* lhs = m_Value;
+        node.GetRHS()->accept(*this);
+        llvm::Value* rhs = m_Value;
+        SetDebugLocation(node.GetStartLocation());
+
+        switch (node.GetOperation()) {
+            case fe::TokenType::Plus: m_Value = m_Builder.CreateAdd(lhs, rhs); break;
+            case fe::TokenType::Minus: m_Value = m_Builder.CreateSub(lhs, rhs); break;
+            case fe::TokenType::Star: m_Value = m_Builder.CreateMul(lhs, rhs); break;
+            case fe::TokenType::Slash:
+                GenerateDivisionChecks(node, lhs, rhs);
+                m_Value = m_Builder.CreateSDiv(lhs, rhs);
+                break;
+            default: llvm_unreachable("unsupported binary operation");
+        }
+    }
+
+    void CodeGen::Visit(const fe::NumberExprAST& node) {
+        m_Value = m_Builder.getInt32(node.GetValue());
+    }
+
+    void CodeGen::Visit(const fe::ProgramAST& node) {
+        std::vector<llvm::Function*> units;
+        const auto& expressions = node.GetExpressions();
+
+        for (size_t i = 0; i < expressions.size(); i++) {
+            units.push_back(GenerateUnit(*expressions[i], i));
+        }
+
+        GenerateMain(node, units);
+        FinalizeDebugInfo();
+    }
+
+    void CodeGen::Visit(const fe::ErrorAST& node) {
+        llvm_unreachable("cannot generate code for an erroneous AST");
+    }
+
+    llvm::Function* CodeGen::GenerateUnit(const fe::GenericASTNode& node, size_t index) {
+        llvm::TimeTraceScope scope("CodeGenUnit", [index] { return GetUnitName(index); });
+
+        llvm::FunctionType* type = llvm::FunctionType::get(m_Builder.getInt32Ty(), false);
+        llvm::Function* unit     = llvm::Function::Create(type, llvm::Function::InternalLinkage, GetUnitName(index), m_Module);
+
+        if (m_DIBuilder) {
+            m_DIScope = CreateDebugFunction(*unit, node.GetStartLocation());
+        }
+
+        m_Builder.SetInsertPoint(llvm::BasicBlock::Create(m_Module.getContext(), "entry", unit));
+        node.accept(*this);
+        SetDebugLocation(node.GetStartLocation());
+        m_Builder.CreateRet(m_Value);
+
+        if (m_DIBuilder) {
+            m_DIBuilder->finalizeSubprogram(unit->getSubprogram());
+            m_Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        }
+
+        assert(!llvm::verifyFunction(*unit, &llvm::errs()));
+        return unit;
+    }
+
+    void CodeGen::FinalizeDebugInfo() {
+        if (m_DIBuilder) {
+            m_DIBuilder->finalize();
+        }
+    }
+
+    void CodeGen::GenerateMain(const fe::ProgramAST& node, const std::vector<llvm::Function*>& units) {
+        llvm::TimeTraceScope scope("CodeGenMain");
+
+        llvm::FunctionCallee printf = m_Module.getOrInsertFunction(
+            "printf", llvm::FunctionType::get(m_Builder.getInt32Ty(), { m_Builder.getInt8PtrTy() }, true));
+
+        llvm::FunctionType* type = llvm::FunctionType::get(m_Builder.getInt32Ty(), false);
+        llvm::Function* main     = llvm::Function::Create(type, llvm::Function::ExternalLinkage, "main", m_Module);
+
+        if (m_DIBuilder) {
+            m_DIScope = CreateDebugFunction(*main, node.GetStartLocation());
+        }
+
+        m_Builder.SetInsertPoint(llvm::BasicBlock::Create(m_Module.getContext(), "entry", main));
+        llvm::Value* format = m_Builder.CreateGlobalStringPtr("%d\n", "optiz.format");
+
+        for (size_t i = 0; i < units.size(); i++) {
+            SetDebugLocation(node.GetExpressions()[i]->GetStartLocation());
+
+            llvm::Value* result = m_Builder.CreateCall(units[i]);
+            m_Builder.CreateCall(printf, { format, result });
+        }
+
+        SetDebugLocation(node.GetEndLocation());
+        m_Builder.CreateRet(m_Builder.getInt32(0));
+
+        if (m_DIBuilder) {
+            m_DIBuilder->finalizeSubprogram(main->getSubprogram());
+            m_Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        }
+
+        assert(!llvm::verifyFunction(*main, &llvm::errs()));
+    }
+
+    void CodeGen::GenerateDivisionChecks(const fe::BinaryExprAST& node, llvm::Value* lhs, llvm::Value* rhs) {
+        auto* divisor = llvm::dyn_cast<llvm::ConstantInt>(rhs);
+
+        if (!divisor || divisor->isZero()) {
+            GenerateCheck(m_Builder.CreateICmpEQ(rhs, m_Builder.getInt32(0)), node.GetStartLocation(), "division by zero");
+        }
+
+        if (!divisor || divisor->isMinusOne()) {
+            llvm::Value* overflow = m_Builder.CreateAnd(m_Builder.CreateICmpEQ(lhs, m_Builder.getInt32(INT32_MIN)),
+                                                        m_Builder.CreateICmpEQ(rhs, m_Builder.getInt32(-1)));
+            GenerateCheck(overflow, node.GetStartLocation(), "division overflow");
+        }
+    }
+
+    void CodeGen::GenerateCheck(llvm::Value* failed, const fe::SrcLocation& location, const std::string& message) {
+        // constant operands fold the condition
+        if (auto* constant = llvm::dyn_cast<llvm::ConstantInt>(failed); constant && constant->isZero()) {
+            return;
+        }
+
+        llvm::LLVMContext& context = m_Module.getContext();
+        llvm::Function* function   = m_Builder.GetInsertBlock()->getParent();
+        llvm::BasicBlock* failure  = llvm::BasicBlock::Create(context, "check.fail", function);
+        llvm::BasicBlock* success  = llvm::BasicBlock::Create(context, "check.ok", function);
+
+        m_Builder.CreateCondBr(failed, failure, success);
+
+        std::string report = GetCheckFailureReport(location, message) + "\n";
+
+        m_Builder.SetInsertPoint(failure);
+        m_Builder.CreateCall(GetCheckFailureHandler(), { m_Builder.CreateGlobalStringPtr(report, "optiz.check.message"),
+                                                         m_Builder.getInt64(report.size()) });
+        m_Builder.CreateUnreachable();
+
+        m_Builder.SetInsertPoint(success);
+    }
+
+    // Flushes the results printed so far, writes the report to stderr and exits
+    // with status 1, like the interpreter does for the same errors.
+    llvm::Function* CodeGen::GetCheckFailureHandler() {
+        if (llvm::Function* handler = m_Module.getFunction(CHECK_FAILURE_HANDLER)) {
+            return handler;
+        }
+
+        llvm::LLVMContext& context = m_Module.getContext();
+        llvm::Type* int8PtrType    = m_Builder.getInt8PtrTy();
+        llvm::Type* int64Type      = m_Builder.getInt64Ty();
+        llvm::Type* int32Type      = m_Builder.getInt32Ty();
+
+        llvm::FunctionType* type = llvm::FunctionType::get(m_Builder.getVoidTy(), { int8PtrType, int64Type }, false);
+        llvm::Function* handler  = llvm::Function::Create(type, llvm::Function::InternalLinkage, CHECK_FAILURE_HANDLER, m_Module);
+        handler->addFnAttr(llvm::Attribute::Cold);
+        handler->addFnAttr(llvm::Attribute::NoReturn);
+        handler->addFnAttr(llvm::Attribute::NoInline);
+
+        llvm::FunctionCallee fflush = m_Module.getOrInsertFunction("fflush", int32Type, int8PtrType);
+        llvm::FunctionCallee write  = m_Module.getOrInsertFunction("write", int64Type, int32Type, int8PtrType, int64Type);
+        llvm::FunctionCallee exit   = m_Module.getOrInsertFunction("exit", m_Builder.getVoidTy(), int32Type);
+
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", handler));
+        builder.CreateCall(fflush, { llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(int8PtrType)) });
+        builder.CreateCall(write, { builder.getInt32(2), handler->getArg(0), handler->getArg(1) });
+        builder.CreateCall(exit, { builder.getInt32(1) });
+        builder.CreateUnreachable();
+
+        return handler;
+    }
+
+    llvm::DISubprogram* CodeGen::CreateDebugFunction(llvm::Function& function, const fe::SrcLocation& location) {
+        llvm::DIType* intType               = m_DIBuilder->createBasicType("int", 32, llvm::dwarf::DW_ATE_signed);
+        llvm::DISubroutineType* type        = m_DIBuilder->createSubroutineType(m_DIBuilder->getOrCreateTypeArray({ intType }));
+        llvm::DISubprogram::DISPFlags flags = llvm::DISubprogram::SPFlagDefinition;
+
+        if (function.hasLocalLinkage()) {
+            flags |= llvm::DISubprogram::SPFlagLocalToUnit;
+        }
+
+        llvm::DISubprogram* subprogram = m_DIBuilder->createFunction(m_DIFile, function.getName(), llvm::StringRef(), m_DIFile,
+                                                                     location.m_Line, type, location.m_Line,
+                                                                     llvm::DINode::FlagPrototyped, flags);
+        function.setSubprogram(subprogram);
+        return subprogram;
+    }
+
+    void CodeGen::SetDebugLocation(const fe::SrcLocation& location) {
+        if (m_DIBuilder) {
+            m_Builder.SetCurrentDebugLocation(llvm::DILocation::get(m_Module.getContext(), location.m_Line, location.m_Column, m_DIScope));
+        }
+    }
+
+}  // namespace optiz::cg
@@ -0,0 +1,105 @@
+#include "cg/CompilationCache.hpp"
+
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+
+#include <chrono>
+
+// file name prefix used by llvm::localCache (and expected by llvm::pruneCache)
+#define ENTRY_PREFIX "llvmcache-"
+
+static void touch(llvm::StringRef path);
+
+namespace optiz::cg {
+
+    CompilationCache::CompilationCache(std::string directory) : m_Directory(std::move(directory)) {}
+
+    llvm::Expected<std::unique_ptr<CompilationCache>> CompilationCache::Create(llvm::StringRef directory) {
+        std::unique_ptr<CompilationCache> compilationCache(new CompilationCache(directory.str()));
+
+        auto cache = llvm::localCache("optiz", "optiz-cache", directory,
+                                      [entry = &compilationCache->m_Entry](unsigned, std::unique_ptr<llvm::MemoryBuffer> buffer) {
+                                          *entry = std::move(buffer);
+                                      });
+        if (!cache) {
+            return cache.takeError();
+        }
+
+        compilationCache->m_Cache = std::move(*cache);
+        return compilationCache;
+    }
+
+    llvm::Expected<llvm::SmallString<0>> CompilationCache::GetOrCompile(
+        llvm::StringRef key, llvm::function_ref<llvm::Error(llvm::raw_pwrite_stream&)> compile) {
+        llvm::SmallString<0> object;
+
+        auto addStream = m_Cache(0, key);
+        if (!addStream) {
+            return addStream.takeError();
+        }
+
+        // a hit returns no stream, the entry has already been handed to m_Entry
+        if (!*addStream) {
+            llvm::SmallString<128> path(m_Directory);
+            llvm::sys::path::append(path, ENTRY_PREFIX + key);
+
+            // keep the entry young for LRU eviction, whatever the mount's atime policy
+            touch(path);
+
+            m_Stats.m_Hits++;
+            object = m_Entry->getBuffer();
+            m_Entry.reset();
+            return object;
+        }
+
+        m_Stats.m_Misses++;
+
+        llvm::raw_svector_ostream out(object);
+        if (llvm::Error error = compile(out)) {
+            return error;
+        }
+
+        auto stream = (*addStream)(0);
+        if (!stream) {
+            return stream.takeError();
+        }
+
+        // the entry is committed when the stream is destroyed
+        *(*stream)->OS << object;
+        stream->reset();
+        m_Entry.reset();
+
+        return object;
+    }
+
+    llvm::Error CompilationCache::Prune(llvm::StringRef policy) {
+        auto pruningPolicy = llvm::parseCachePruningPolicy(policy);
+        if (!pruningPolicy) {
+            return pruningPolicy.takeError();
+        }
+
+        llvm::pruneCache(m_Directory, *pruningPolicy);
+        return llvm::Error::success();
+    }
+
+    const CacheStats& CompilationCache::GetStats() const {
+        return m_Stats;
+    }
+
+}  // namespace optiz::cg
+
+#undef ENTRY_PREFIX
+
+static void touch(llvm::StringRef path) {
+    int fd;
+
+    if (llvm::sys::fs::openFileForWrite(path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_Append)) {
+        return;
+    }
+
+    llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+}
@@ -0,0 +1,169 @@
+#include "cg/Profile.hpp"
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ProfileSummary.h>
+#include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ProfileData/ProfileCommon.h>
+#include <llvm/Support/LineIterator.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#define PROFILE_HEADER   "optiz-profile 1"
+#define PROFILE_COUNTERS "optiz.profile.counters"
+#define PROFILE_WRITER   "optiz.profile.write"
+
+static llvm::Function* createProfileWriter(llvm::Module& module, llvm::GlobalVariable* counters,
+                                           llvm::ArrayRef<optiz::cg::ProfileUnit> units, llvm::StringRef profileFile);
+
+namespace optiz::cg {
+
+    void InstrumentModule(llvm::Module& module, llvm::ArrayRef<ProfileUnit> units, llvm::StringRef profileFile) {
+        llvm::LLVMContext& context = module.getContext();
+        llvm::Type* int64Type      = llvm::Type::getInt64Ty(context);
+        llvm::ArrayType* arrayType = llvm::ArrayType::get(int64Type, units.size());
+
+        auto* counters = new llvm::GlobalVariable(module, arrayType, false, llvm::GlobalValue::InternalLinkage,
+                                                  llvm::ConstantAggregateZero::get(arrayType), PROFILE_COUNTERS);
+
+        for (size_t i = 0; i < units.size(); i++) {
+            llvm::Function* function = module.getFunction(units[i].m_Name);
+            if (!function || function->isDeclaration()) {
+                continue;
+            }
+
+            // programs are single-threaded, a plain increment is enough
+            llvm::IRBuilder<> builder(&*function->getEntryBlock().getFirstInsertionPt());
+            llvm::Value* counter = builder.CreateConstInBoundsGEP2_64(arrayType, counters, 0, i);
+            llvm::Value* count   = builder.CreateLoad(int64Type, counter);
+            builder.CreateStore(builder.CreateAdd(count, builder.getInt64(1)), counter);
+        }
+
+        llvm::Function* writer = createProfileWriter(module, counters, units, profileFile);
+
+        llvm::Function* main = module.getFunction("main");
+        if (!main) {
+            return;
+        }
+
+        for (llvm::BasicBlock& block : *main) {
+            if (auto* ret = llvm::dyn_cast<llvm::ReturnInst>(block.getTerminator())) {
+                llvm::CallInst::Create(writer, "", ret);
+            }
+        }
+    }
+
+    llvm::Expected<Profile> ReadProfile(llvm::StringRef profileFile) {
+        auto buffer = llvm::MemoryBuffer::getFile(profileFile);
+        if (!buffer) {
+            return llvm::createStringError(buffer.getError(),
+                                           "cannot read profile '" + profileFile + "': " + buffer.getError().message());
+        }
+
+        llvm::line_iterator line(**buffer);
+        if (line.is_at_end() || *line != PROFILE_HEADER) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "'" + profileFile + "' is not an optiz profile");
+        }
+
+        Profile profile;
+
+        for (++line; !line.is_at_end(); ++line) {
+            llvm::SmallVector<llvm::StringRef, 3> fields;
+            line->split(fields, ' ', -1, false);
+
+            uint64_t count;
+            if (fields.size() != 3 || fields[2].getAsInteger(10, count)) {
+                return llvm::createStringError(llvm::inconvertibleErrorCode(), "%s:%lld: malformed profile record",
+                                               profileFile.str().c_str(), static_cast<long long>(line.line_number()));
+            }
+
+            profile[fields[0]] = ProfileRecord{ fields[1].str(), count };
+        }
+
+        return profile;
+    }
+
+    std::vector<std::string> ApplyProfile(llvm::Module& module, llvm::ArrayRef<ProfileUnit> units, const Profile& profile) {
+        llvm::InstrProfSummaryBuilder summaryBuilder(llvm::ProfileSummaryBuilder::DefaultCutoffs);
+        std::vector<std::string> staleUnits;
+        bool applied = false;
+
+        for (const ProfileUnit& unit : units) {
+            llvm::Function* function = module.getFunction(unit.m_Name);
+            if (!function || function->isDeclaration()) {
+                continue;
+            }
+
+            auto record = profile.find(unit.m_Name);
+            if (record == profile.end() || record->second.m_Hash != unit.m_Hash) {
+                staleUnits.push_back(unit.m_Name);
+                continue;
+            }
+
+            uint64_t count = record->second.m_EntryCount;
+            function->setEntryCount(count);
+            summaryBuilder.addRecord(llvm::InstrProfRecord({ count }));
+            applied = true;
+        }
+
+        // without a summary the optimizer ignores the entry counts
+        if (applied) {
+            module.setProfileSummary(summaryBuilder.getSummary()->getMD(module.getContext()), llvm::ProfileSummary::PSK_Instr);
+        }
+
+        return staleUnits;
+    }
+
+}  // namespace optiz::cg
+
+// Writes "<name> <hash> <count>" for every unit, after a header line, or
+// says on stderr that the profile cannot be written.
+static llvm::Function* createProfileWriter(llvm::Module& module, llvm::GlobalVariable* counters,
+                                           llvm::ArrayRef<optiz::cg::ProfileUnit> units, llvm::StringRef profileFile) {
+    llvm::LLVMContext& context = module.getContext();
+    llvm::Type* int8PtrType    = llvm::Type::getInt8PtrTy(context);
+    llvm::Type* int64Type      = llvm::Type::getInt64Ty(context);
+    llvm::Type* int32Type      = llvm::Type::getInt32Ty(context);
+
+    llvm::FunctionType* type = llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+    llvm::Function* writer   = llvm::Function::Create(type, llvm::Function::InternalLinkage, PROFILE_WRITER, module);
+    writer->addFnAttr(llvm::Attribute::Cold);
+    writer->addFnAttr(llvm::Attribute::NoInline);
+
+    llvm::FunctionCallee fopen   = module.getOrInsertFunction("fopen", int8PtrType, int8PtrType, int8PtrType);
+    llvm::FunctionCallee fprintf = module.getOrInsertFunction("fprintf", llvm::FunctionType::get(int32Type, { int8PtrType, int8PtrType }, true));
+    llvm::FunctionCallee fclose  = module.getOrInsertFunction("fclose", int32Type, int8PtrType);
+    llvm::FunctionCallee dprintf = module.getOrInsertFunction("dprintf", llvm::FunctionType::get(int32Type, { int32Type, int8PtrType }, true));
+
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", writer);
+    llvm::BasicBlock* write = llvm::BasicBlock::Create(context, "write", writer);
+    llvm::BasicBlock* fail  = llvm::BasicBlock::Create(context, "fail", writer);
+    llvm::BasicBlock* done  = llvm::BasicBlock::Create(context, "done", writer);
+
+    llvm::IRBuilder<> builder(entry);
+    llvm::Value* path = builder.CreateGlobalStringPtr(profileFile);
+    llvm::Value* file = builder.CreateCall(fopen, { path, builder.CreateGlobalStringPtr("w") });
+    builder.CreateCondBr(builder.CreateIsNull(file), fail, write);
+
+    // the path goes in as an argument, it may contain '%'
+    builder.SetInsertPoint(fail);
+    builder.CreateCall(dprintf, { builder.getInt32(2), builder.CreateGlobalStringPtr("optiz: cannot write profile '%s'\n"), path });
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(write);
+    builder.CreateCall(fprintf, { file, builder.CreateGlobalStringPtr(PROFILE_HEADER "\n") });
+
+    for (size_t i = 0; i < units.size(); i++) {
+        std::string format   = units[i].m_Name + " " + units[i].m_Hash + " %llu\n";
+        llvm::Value* counter = builder.CreateConstInBoundsGEP2_64(counters->getValueType(), counters, 0, i);
+
+        builder.CreateCall(fprintf, { file, builder.CreateGlobalStringPtr(format), builder.CreateLoad(int64Type, counter) });
+    }
+
+    builder.CreateCall(fclose, { file });
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    builder.CreateRetVoid();
+
+    return writer;
+}
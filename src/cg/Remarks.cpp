@@ -0,0 +1,75 @@
+#include "cg/Remarks.hpp"
+
+#include <llvm/IR/DiagnosticInfo.h>
+
+static std::unique_ptr<llvm::Regex> createFilter(const std::string& pattern);
+static bool matches(const std::unique_ptr<llvm::Regex>& filter, llvm::StringRef passName);
+
+namespace optiz::cg {
+
+    RemarkHandler::RemarkHandler(fe::DiagnosticEngine& diagnosticEngine, std::string file, const RemarkFilters& filters)
+        : m_DiagnosticEngine(diagnosticEngine),
+          m_File(std::move(file)),
+          m_Passed(createFilter(filters.m_Passed)),
+          m_Missed(createFilter(filters.m_Missed)),
+          m_Analysis(createFilter(filters.m_Analysis)) {}
+
+    bool RemarkHandler::handleDiagnostics(const llvm::DiagnosticInfo& info) {
+        const auto* remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+        if (!remark) {
+            return false;
+        }
+
+        // the context hands over every remark when a remarks file is written as well
+        llvm::StringRef option;
+        if (remark->isPassed() && isPassedOptRemarkEnabled(remark->getPassName())) {
+            option = "-Rpass";
+        } else if (remark->isMissed() && isMissedOptRemarkEnabled(remark->getPassName())) {
+            option = "-Rpass-missed";
+        } else if (remark->isAnalysis() && isAnalysisRemarkEnabled(remark->getPassName())) {
+            option = "-Rpass-analysis";
+        } else {
+            return true;
+        }
+
+        fe::SrcLocation location = { 0, 0, m_File };
+        if (remark->isLocationAvailable()) {
+            location.m_Line   = remark->getLocation().getLine();
+            location.m_Column = remark->getLocation().getColumn();
+        }
+
+        std::string message = remark->getMsg() + " [" + option.str() + "=" + remark->getPassName().str() + "]";
+        m_DiagnosticEngine.Report(location, message, fe::DiagnosticLevel::Info);
+
+        return true;
+    }
+
+    bool RemarkHandler::isAnalysisRemarkEnabled(llvm::StringRef passName) const {
+        return matches(m_Analysis, passName);
+    }
+
+    bool RemarkHandler::isMissedOptRemarkEnabled(llvm::StringRef passName) const {
+        return matches(m_Missed, passName);
+    }
+
+    bool RemarkHandler::isPassedOptRemarkEnabled(llvm::StringRef passName) const {
+        return matches(m_Passed, passName);
+    }
+
+    bool RemarkHandler::isAnyRemarkEnabled() const {
+        return m_Passed || m_Missed || m_Analysis;
+    }
+
+}  // namespace optiz::cg
+
+static std::unique_ptr<llvm::Regex> createFilter(const std::string& pattern) {
+    if (pattern.empty()) {
+        return nullptr;
+    }
+
+    return std::make_unique<llvm::Regex>(pattern);
+}
+
+static bool matches(const std::unique_ptr<llvm::Regex>& filter, llvm::StringRef passName) {
+    return filter && filter->match(passName);
+}
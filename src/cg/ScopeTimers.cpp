@@ -0,0 +1,181 @@
+#include "cg/ScopeTimers.hpp"
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <vector>
+
+#define SCOPE_CALLS    "optiz.scope.calls"
+#define SCOPE_CYCLES   "optiz.scope.cycles"
+#define SCOPE_REPORTER "optiz.scope.report"
+
+static llvm::Function* createScopeReporter(llvm::Module& module, llvm::GlobalVariable* calls, llvm::GlobalVariable* cycles,
+                                           llvm::ArrayRef<optiz::cg::InstrumentedScope> scopes, llvm::StringRef reportFile);
+static std::string formatLocation(const optiz::fe::SrcLocation& location);
+static std::string toJSONString(llvm::StringRef value);
+
+namespace optiz::cg {
+
+    void InstrumentScopes(llvm::Module& module, llvm::ArrayRef<InstrumentedScope> scopes, llvm::StringRef reportFile) {
+        llvm::LLVMContext& context = module.getContext();
+        llvm::Type* int64Type      = llvm::Type::getInt64Ty(context);
+        llvm::ArrayType* arrayType = llvm::ArrayType::get(int64Type, scopes.size());
+
+        // programs are single-threaded, so the counters need neither atomics
+        // nor thread-local copies
+        auto createCounters = [&](const char* name) {
+            return new llvm::GlobalVariable(module, arrayType, false, llvm::GlobalValue::InternalLinkage,
+                                            llvm::ConstantAggregateZero::get(arrayType), name);
+        };
+        llvm::GlobalVariable* calls  = createCounters(SCOPE_CALLS);
+        llvm::GlobalVariable* cycles = createCounters(SCOPE_CYCLES);
+
+        llvm::Function* readCycleCounter = llvm::Intrinsic::getDeclaration(&module, llvm::Intrinsic::readcyclecounter);
+
+        for (size_t i = 0; i < scopes.size(); i++) {
+            llvm::Function* function = module.getFunction(scopes[i].m_Function);
+            if (!function || function->isDeclaration()) {
+                continue;
+            }
+
+            llvm::IRBuilder<> builder(&*function->getEntryBlock().getFirstInsertionPt());
+            llvm::Value* start = builder.CreateCall(readCycleCounter, {}, "scope.start");
+
+            std::vector<llvm::ReturnInst*> returns;
+            for (llvm::BasicBlock& block : *function) {
+                if (auto* ret = llvm::dyn_cast<llvm::ReturnInst>(block.getTerminator())) {
+                    returns.push_back(ret);
+                }
+            }
+
+            for (llvm::ReturnInst* ret : returns) {
+                builder.SetInsertPoint(ret);
+                llvm::Value* elapsed = builder.CreateSub(builder.CreateCall(readCycleCounter), start);
+
+                llvm::Value* callCount  = builder.CreateConstInBoundsGEP2_64(arrayType, calls, 0, i);
+                llvm::Value* cycleCount = builder.CreateConstInBoundsGEP2_64(arrayType, cycles, 0, i);
+                builder.CreateStore(builder.CreateAdd(builder.CreateLoad(int64Type, callCount), builder.getInt64(1)), callCount);
+                builder.CreateStore(builder.CreateAdd(builder.CreateLoad(int64Type, cycleCount), elapsed), cycleCount);
+            }
+        }
+
+        llvm::Function* reporter = createScopeReporter(module, calls, cycles, scopes, reportFile);
+
+        llvm::Function* main = module.getFunction("main");
+        if (!main) {
+            return;
+        }
+
+        for (llvm::BasicBlock& block : *main) {
+            if (auto* ret = llvm::dyn_cast<llvm::ReturnInst>(block.getTerminator())) {
+                llvm::CallInst::Create(reporter, "", ret);
+            }
+        }
+    }
+
+}  // namespace optiz::cg
+
+// Prints the table to stderr after the program's own output and, with a
+// report file, writes {"scopes": [{"function", "location", "calls", "cycles"}, ...]}.
+static llvm::Function* createScopeReporter(llvm::Module& module, llvm::GlobalVariable* calls, llvm::GlobalVariable* cycles,
+                                           llvm::ArrayRef<optiz::cg::InstrumentedScope> scopes, llvm::StringRef reportFile) {
+    llvm::LLVMContext& context = module.getContext();
+    llvm::Type* int8PtrType    = llvm::Type::getInt8PtrTy(context);
+    llvm::Type* int64Type      = llvm::Type::getInt64Ty(context);
+    llvm::Type* int32Type      = llvm::Type::getInt32Ty(context);
+    llvm::Type* arrayType      = calls->getValueType();
+
+    llvm::FunctionType* type   = llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+    llvm::Function* reporter   = llvm::Function::Create(type, llvm::Function::InternalLinkage, SCOPE_REPORTER, module);
+    reporter->addFnAttr(llvm::Attribute::Cold);
+    reporter->addFnAttr(llvm::Attribute::NoInline);
+
+    llvm::FunctionCallee fflush  = module.getOrInsertFunction("fflush", int32Type, int8PtrType);
+    llvm::FunctionCallee dprintf = module.getOrInsertFunction("dprintf", llvm::FunctionType::get(int32Type, { int32Type, int8PtrType }, true));
+    llvm::FunctionCallee fopen   = module.getOrInsertFunction("fopen", int8PtrType, int8PtrType, int8PtrType);
+    llvm::FunctionCallee fprintf = module.getOrInsertFunction("fprintf", llvm::FunctionType::get(int32Type, { int8PtrType, int8PtrType }, true));
+    llvm::FunctionCallee fclose  = module.getOrInsertFunction("fclose", int32Type, int8PtrType);
+
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", reporter));
+    builder.CreateCall(fflush, { llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(int8PtrType)) });
+
+    std::vector<llvm::Value*> callCounts;
+    std::vector<llvm::Value*> cycleCounts;
+
+    for (size_t i = 0; i < scopes.size(); i++) {
+        callCounts.push_back(builder.CreateLoad(int64Type, builder.CreateConstInBoundsGEP2_64(arrayType, calls, 0, i)));
+        cycleCounts.push_back(builder.CreateLoad(int64Type, builder.CreateConstInBoundsGEP2_64(arrayType, cycles, 0, i)));
+    }
+
+    llvm::Value* stderrFd = builder.getInt32(2);
+    llvm::Value* row      = builder.CreateGlobalStringPtr("%-32s %-16s %12llu %16llu %12llu\n");
+
+    builder.CreateCall(dprintf, { stderrFd, builder.CreateGlobalStringPtr("%-32s %-16s %12s %16s %12s\n"),
+                                  builder.CreateGlobalStringPtr("scope"), builder.CreateGlobalStringPtr("function"),
+                                  builder.CreateGlobalStringPtr("calls"), builder.CreateGlobalStringPtr("cycles"),
+                                  builder.CreateGlobalStringPtr("cycles/call") });
+
+    for (size_t i = 0; i < scopes.size(); i++) {
+        llvm::Value* divisor = builder.CreateSelect(builder.CreateIsNull(callCounts[i]), builder.getInt64(1), callCounts[i]);
+
+        builder.CreateCall(dprintf, { stderrFd, row, builder.CreateGlobalStringPtr(formatLocation(scopes[i].m_Location)),
+                                      builder.CreateGlobalStringPtr(scopes[i].m_Function), callCounts[i], cycleCounts[i],
+                                      builder.CreateUDiv(cycleCounts[i], divisor) });
+    }
+
+    if (reportFile.empty()) {
+        builder.CreateRetVoid();
+        return reporter;
+    }
+
+    llvm::BasicBlock* write = llvm::BasicBlock::Create(context, "write", reporter);
+    llvm::BasicBlock* fail  = llvm::BasicBlock::Create(context, "fail", reporter);
+    llvm::BasicBlock* done  = llvm::BasicBlock::Create(context, "done", reporter);
+
+    llvm::Value* path = builder.CreateGlobalStringPtr(reportFile);
+    llvm::Value* file = builder.CreateCall(fopen, { path, builder.CreateGlobalStringPtr("w") });
+    builder.CreateCondBr(builder.CreateIsNull(file), fail, write);
+
+    // the path goes in as an argument, it may contain '%'
+    builder.SetInsertPoint(fail);
+    builder.CreateCall(dprintf, { stderrFd, builder.CreateGlobalStringPtr("optiz: cannot write scope report '%s'\n"), path });
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(write);
+    builder.CreateCall(fprintf, { file, builder.CreateGlobalStringPtr("{\"scopes\": [\n") });
+
+    for (size_t i = 0; i < scopes.size(); i++) {
+        // strings go in as arguments, file names may contain '%'
+        std::string format = "  {\"function\": %s, \"location\": %s, \"calls\": %llu, \"cycles\": %llu}";
+        format += i + 1 < scopes.size() ? ",\n" : "\n";
+
+        builder.CreateCall(fprintf, { file, builder.CreateGlobalStringPtr(format),
+                                      builder.CreateGlobalStringPtr(toJSONString(scopes[i].m_Function)),
+                                      builder.CreateGlobalStringPtr(toJSONString(formatLocation(scopes[i].m_Location))),
+                                      callCounts[i], cycleCounts[i] });
+    }
+
+    builder.CreateCall(fprintf, { file, builder.CreateGlobalStringPtr("]}\n") });
+    builder.CreateCall(fclose, { file });
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    builder.CreateRetVoid();
+
+    return reporter;
+}
+
+static std::string formatLocation(const optiz::fe::SrcLocation& location) {
+    return location.m_File + ":" + std::to_string(location.m_Line) + ":" + std::to_string(location.m_Column);
+}
+
+static std::string toJSONString(llvm::StringRef value) {
+    std::string json;
+    llvm::raw_string_ostream out(json);
+    out << llvm::json::Value(llvm::json::fixUTF8(value));
+
+    return json;
+}
@@ -0,0 +1,126 @@
+#include "cg/TargetClones.hpp"
+
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/IR/GlobalIFunc.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/X86TargetParser.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <algorithm>
+#include <vector>
+
+#define DEFAULT_TARGET "default"
+
+static llvm::Optional<llvm::X86::ProcessorFeatures> getProcessorFeature(llvm::StringRef name);
+static llvm::Value* emitCPUSupports(llvm::IRBuilder<>& builder, llvm::Module& module, llvm::StringRef feature);
+
+namespace optiz::cg {
+
+    struct TargetClone {
+        std::string m_Feature;
+        unsigned m_Priority;
+        llvm::Function* m_Function;
+    };
+
+    llvm::Error CreateTargetClones(llvm::Function& function, const llvm::TargetMachine& targetMachine,
+                                   llvm::ArrayRef<std::string> targets) {
+        if (!targetMachine.getTargetTriple().isX86()) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "target clones are only supported on x86");
+        }
+
+        std::vector<TargetClone> clones;
+
+        for (const std::string& target : targets) {
+            if (target == DEFAULT_TARGET) {
+                continue;
+            }
+
+            llvm::Optional<llvm::X86::ProcessorFeatures> feature = getProcessorFeature(target);
+            if (!feature) {
+                return llvm::createStringError(llvm::inconvertibleErrorCode(), "unknown target clone '" + target + "'");
+            }
+
+            clones.push_back(TargetClone{ target, llvm::X86::getFeaturePriority(*feature), nullptr });
+        }
+
+        // the resolver tests the most capable feature sets first
+        std::stable_sort(clones.begin(), clones.end(),
+                         [](const TargetClone& a, const TargetClone& b) { return a.m_Priority > b.m_Priority; });
+
+        llvm::Module& module                    = *function.getParent();
+        llvm::LLVMContext& context              = module.getContext();
+        std::string name                        = function.getName().str();
+        std::string baseFeatures                = targetMachine.getTargetFeatureString().str();
+        llvm::GlobalValue::LinkageTypes linkage = function.getLinkage();
+
+        function.setName(name + "." DEFAULT_TARGET);
+        function.setLinkage(llvm::GlobalValue::InternalLinkage);
+
+        for (TargetClone& clone : clones) {
+            llvm::ValueToValueMapTy valueMap;
+            clone.m_Function = llvm::CloneFunction(&function, valueMap);
+            clone.m_Function->setName(name + "." + clone.m_Feature);
+            clone.m_Function->addFnAttr("target-features", (baseFeatures.empty() ? "" : baseFeatures + ",") + "+" + clone.m_Feature);
+        }
+
+        llvm::FunctionType* resolverType = llvm::FunctionType::get(function.getType(), false);
+        llvm::Function* resolver = llvm::Function::Create(resolverType, llvm::Function::InternalLinkage, name + ".resolver", module);
+
+        // callers go through the ifunc from now on, the resolver is the only user of the default version
+        auto* ifunc = llvm::GlobalIFunc::create(function.getFunctionType(), function.getAddressSpace(), linkage, name, resolver, &module);
+        ifunc->setVisibility(function.getVisibility());
+        function.replaceAllUsesWith(ifunc);
+        function.setVisibility(llvm::GlobalValue::DefaultVisibility);
+
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", resolver));
+        builder.CreateCall(module.getOrInsertFunction("__cpu_indicator_init", builder.getVoidTy()));
+
+        for (const TargetClone& clone : clones) {
+            llvm::BasicBlock* selected = llvm::BasicBlock::Create(context, clone.m_Feature, resolver);
+            llvm::BasicBlock* next     = llvm::BasicBlock::Create(context, "", resolver);
+
+            builder.CreateCondBr(emitCPUSupports(builder, module, clone.m_Feature), selected, next);
+
+            builder.SetInsertPoint(selected);
+            builder.CreateRet(clone.m_Function);
+
+            builder.SetInsertPoint(next);
+        }
+
+        builder.CreateRet(&function);
+
+        return llvm::Error::success();
+    }
+
+}  // namespace optiz::cg
+
+static llvm::Optional<llvm::X86::ProcessorFeatures> getProcessorFeature(llvm::StringRef name) {
+    return llvm::StringSwitch<llvm::Optional<llvm::X86::ProcessorFeatures>>(name)
+#define X86_FEATURE_COMPAT(ENUM, STR, PRIORITY) .Case(STR, llvm::X86::FEATURE_##ENUM)
+#include <llvm/Support/X86TargetParser.def>
+        .Default(llvm::None);
+}
+
+// Same layout and test as clang's __builtin_cpu_supports: the first 32 feature
+// bits live in __cpu_model.__cpu_features[0], the next ones in __cpu_features2.
+static llvm::Value* emitCPUSupports(llvm::IRBuilder<>& builder, llvm::Module& module, llvm::StringRef feature) {
+    uint64_t mask         = llvm::X86::getCpuSupportsMask({ feature });
+    llvm::Type* int32Type = builder.getInt32Ty();
+    llvm::Value* featuresAddress;
+
+    if (mask & 0xffffffff) {
+        llvm::ArrayType* featuresType = llvm::ArrayType::get(int32Type, 1);
+        llvm::StructType* modelType   = llvm::StructType::get(int32Type, int32Type, int32Type, featuresType);
+        llvm::Constant* model         = module.getOrInsertGlobal("__cpu_model", modelType);
+
+        featuresAddress = builder.CreateConstInBoundsGEP2_32(featuresType, builder.CreateConstInBoundsGEP2_32(modelType, model, 0, 3), 0, 0);
+    } else {
+        featuresAddress = module.getOrInsertGlobal("__cpu_features2", int32Type);
+        mask >>= 32;
+    }
+
+    llvm::Value* features = builder.CreateAlignedLoad(int32Type, featuresAddress, llvm::Align(4));
+    llvm::Value* masked   = builder.CreateAnd(features, static_cast<uint32_t>(mask));
+
+    return builder.CreateICmpEQ(masked, builder.getInt32(static_cast<uint32_t>(mask)));
+}
@@ -1,5 +1,7 @@
 #include "fe/AST.hpp"
 
+#include "fe/Statistics.hpp"
+
 #define ACCEPT_IMPL(T) \
     void T::accept(ASTVisitor& visitor) const { visitor.Visit(*this); }
 
@@ -11,20 +13,30 @@ namespace optiz::fe {
     GenericASTNode::GenericASTNode(NodeKind kind, SrcLocation startLocation, SrcLocation endLocation)
         : m_Kind(kind), m_StartLocation(startLocation), m_EndLocation(endLocation) {}
 
-    ErrorAST::ErrorAST() : GenericASTNode(NodeKind::ErrorAST, SrcLocation(), SrcLocation()) {}
+    ErrorAST::ErrorAST() : GenericASTNode(NodeKind::ErrorAST, SrcLocation(), SrcLocation()) {
+        OPTIZ_STAT(CountNode(*this, sizeof(ErrorAST)));
+    }
 
     NumberExprAST::NumberExprAST(int value, SrcLocation startLocation, SrcLocation endLocation)
-        : GenericASTNode(NodeKind::NumberExprAST, startLocation, endLocation), m_Value(value) {}
+        : GenericASTNode(NodeKind::NumberExprAST, startLocation, endLocation), m_Value(value) {
+        OPTIZ_STAT(CountNode(*this, sizeof(NumberExprAST)));
+    }
 
     UnaryExprAST::UnaryExprAST(TokenType operation, std::unique_ptr<GenericASTNode> expr, SrcLocation startLocation, SrcLocation endLocation)
-        : GenericASTNode(NodeKind::UnaryExprAST, startLocation, endLocation), m_Operation(operation), m_Expression(std::move(expr)) {}
+        : GenericASTNode(NodeKind::UnaryExprAST, startLocation, endLocation), m_Operation(operation), m_Expression(std::move(expr)) {
+        OPTIZ_STAT(CountNode(*this, sizeof(UnaryExprAST)));
+    }
 
     BinaryExprAST::BinaryExprAST(std::unique_ptr<GenericASTNode> left, std::unique_ptr<GenericASTNode> right, TokenType operation,
                                  SrcLocation startLocation, SrcLocation endLocation)
-        : GenericASTNode(NodeKind::BinaryExprAST, startLocation, endLocation), m_LHS(std::move(left)), m_RHS(std::move(right)), m_Operation(operation) {}
+        : GenericASTNode(NodeKind::BinaryExprAST, startLocation, endLocation), m_LHS(std::move(left)), m_RHS(std::move(right)), m_Operation(operation) {
+        OPTIZ_STAT(CountNode(*this, sizeof(BinaryExprAST)));
+    }
 
     ProgramAST::ProgramAST(std::vector<std::unique_ptr<GenericASTNode>> expressions, SrcLocation startLocation, SrcLocation endLocation)
-        : GenericASTNode(NodeKind::ProgramAST, startLocation, endLocation), m_Expressions(std::move(expressions)) {}
+        : GenericASTNode(NodeKind::ProgramAST, startLocation, endLocation), m_Expressions(std::move(expressions)) {
+        OPTIZ_STAT(CountNode(*this, sizeof(ProgramAST) + m_Expressions.capacity() * sizeof(std::unique_ptr<GenericASTNode>)));
+    }
 
     NodeKind GenericASTNode::GetKind() const {
         return m_Kind;
@@ -50,6 +62,10 @@ namespace optiz::fe {
         return m_Expression.get();
     }
 
+    std::unique_ptr<GenericASTNode>& UnaryExprAST::GetMutableExpr() {
+        return m_Expression;
+    }
+
     const GenericASTNode* BinaryExprAST::GetLHS() const {
         return m_LHS.get();
     }
@@ -58,6 +74,14 @@ namespace optiz::fe {
         return m_RHS.get();
     }
 
+    std::unique_ptr<GenericASTNode>& BinaryExprAST::GetMutableLHS() {
+        return m_LHS;
+    }
+
+    std::unique_ptr<GenericASTNode>& BinaryExprAST::GetMutableRHS() {
+        return m_RHS;
+    }
+
     TokenType BinaryExprAST::GetOperation() const {
         return m_Operation;
     }
@@ -66,6 +90,10 @@ namespace optiz::fe {
         return m_Expressions;
     }
 
+    std::vector<std::unique_ptr<GenericASTNode>>& ProgramAST::GetMutableExpressions() {
+        return m_Expressions;
+    }
+
     ACCEPT_IMPL(ErrorAST)
     CLASSOF_IMPL(ErrorAST)
 
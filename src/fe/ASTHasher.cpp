@@ -0,0 +1,66 @@
+#include "fe/ASTHasher.hpp"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Endian.h>
+
+#include "fe/AST.hpp"
+
+namespace optiz::fe {
+
+    ASTHasher::ASTHasher(llvm::SHA1& hasher, HashedLocations hashedLocations) : m_Hasher(hasher), m_HashedLocations(hashedLocations) {}
+
+    void ASTHasher::Visit(const UnaryExprAST& node) {
+        Update(static_cast<uint32_t>(node.GetKind()));
+        Update(static_cast<uint32_t>(node.getOperation()));
+        UpdateLocation(node);
+        node.GetExpr()->accept(*this);
+    }
+
+    void ASTHasher::Visit(const BinaryExprAST& node) {
+        Update(static_cast<uint32_t>(node.GetKind()));
+        Update(static_cast<uint32_t>(node.GetOperation()));
+        UpdateLocation(node, node.GetOperation() == TokenType::Slash);
+        node.GetLHS()->accept(*this);
+        node.GetRHS()->accept(*this);
+    }
+
+    void ASTHasher::Visit(const NumberExprAST& node) {
+        Update(static_cast<uint32_t>(node.GetKind()));
+        Update(static_cast<uint32_t>(node.GetValue()));
+        UpdateLocation(node);
+    }
+
+    void ASTHasher::Visit(const ProgramAST& node) {
+        Update(static_cast<uint32_t>(node.GetKind()));
+        Update(node.GetExpressions().size());
+        UpdateLocation(node);
+
+        for (const auto& expression : node.GetExpressions()) {
+            expression->accept(*this);
+        }
+    }
+
+    void ASTHasher::Visit(const ErrorAST& node) {
+        Update(static_cast<uint32_t>(node.GetKind()));
+    }
+
+    void ASTHasher::Update(uint32_t value) {
+        uint8_t bytes[sizeof(value)];
+        llvm::support::endian::write32le(bytes, value);
+        m_Hasher.update(llvm::ArrayRef<uint8_t>(bytes));
+    }
+
+    void ASTHasher::UpdateLocation(const GenericASTNode& node, bool isDivision) {
+        if (m_HashedLocations == HashedLocations::None || (m_HashedLocations == HashedLocations::Divisions && !isDivision)) {
+            return;
+        }
+
+        for (const SrcLocation* location : { &node.GetStartLocation(), &node.GetEndLocation() }) {
+            Update(location->m_Line);
+            Update(location->m_Column);
+            Update(location->m_File.size());
+            m_Hasher.update(llvm::StringRef(location->m_File));
+        }
+    }
+
+}  // namespace optiz::fe
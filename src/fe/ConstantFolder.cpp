@@ -0,0 +1,157 @@
+#include "fe/ConstantFolder.hpp"
+
+#include <llvm/Support/Casting.h>
+
+#include <cstdint>
+#include <limits>
+
+static std::optional<int> evaluateUnary(optiz::fe::TokenType operation, int operand);
+static std::optional<int> evaluateBinary(optiz::fe::TokenType operation, int lhs, int rhs);
+static std::optional<int> getConstant(const optiz::fe::GenericASTNode& node);
+static bool isIdentityOperand(optiz::fe::TokenType operation, int value, bool isRHS);
+
+namespace optiz::fe {
+
+    ConstantFolder::ConstantFolder() : m_FoldedNodes(0), m_SimplifiedNodes(0) {}
+
+    std::unique_ptr<GenericASTNode> ConstantFolder::Fold(std::unique_ptr<GenericASTNode> node) {
+        GenericASTNode& visited = *node;
+
+        m_Result = std::move(node);
+        visited.accept(*this);
+        return std::move(m_Result);
+    }
+
+    size_t ConstantFolder::GetFoldedNodeCount() const {
+        return m_FoldedNodes;
+    }
+
+    size_t ConstantFolder::GetSimplifiedNodeCount() const {
+        return m_SimplifiedNodes;
+    }
+
+    void ConstantFolder::Visit(const UnaryExprAST& node) {
+        std::unique_ptr<GenericASTNode> self     = std::move(m_Result);
+        std::unique_ptr<GenericASTNode>& operand = llvm::cast<UnaryExprAST>(*self).GetMutableExpr();
+        operand                                  = Fold(std::move(operand));
+
+        if (std::optional<int> operandValue = getConstant(*operand)) {
+            if (std::optional<int> value = evaluateUnary(node.getOperation(), *operandValue)) {
+                m_Result = std::make_unique<NumberExprAST>(*value, node.GetStartLocation(), node.GetEndLocation());
+                m_FoldedNodes++;
+                return;
+            }
+        }
+
+        bool isDoubleNegation = node.getOperation() == TokenType::Minus && llvm::isa<UnaryExprAST>(operand.get()) &&
+                                llvm::cast<UnaryExprAST>(operand.get())->getOperation() == TokenType::Minus;
+
+        if (node.getOperation() == TokenType::Plus) {
+            m_Result = std::move(operand);
+            m_SimplifiedNodes++;
+        } else if (isDoubleNegation) {
+            m_Result = std::move(llvm::cast<UnaryExprAST>(*operand).GetMutableExpr());
+            m_SimplifiedNodes += 2;
+        } else {
+            m_Result = std::move(self);
+        }
+    }
+
+    void ConstantFolder::Visit(const BinaryExprAST& node) {
+        std::unique_ptr<GenericASTNode> self = std::move(m_Result);
+        std::unique_ptr<GenericASTNode>& lhs = llvm::cast<BinaryExprAST>(*self).GetMutableLHS();
+        std::unique_ptr<GenericASTNode>& rhs = llvm::cast<BinaryExprAST>(*self).GetMutableRHS();
+        lhs                                  = Fold(std::move(lhs));
+        rhs                                  = Fold(std::move(rhs));
+        std::optional<int> lhsValue          = getConstant(*lhs);
+        std::optional<int> rhsValue          = getConstant(*rhs);
+
+        if (lhsValue && rhsValue) {
+            if (std::optional<int> value = evaluateBinary(node.GetOperation(), *lhsValue, *rhsValue)) {
+                m_Result = std::make_unique<NumberExprAST>(*value, node.GetStartLocation(), node.GetEndLocation());
+                m_FoldedNodes++;
+                return;
+            }
+        }
+
+        if (rhsValue && isIdentityOperand(node.GetOperation(), *rhsValue, true)) {
+            m_Result = std::move(lhs);
+        } else if (lhsValue && isIdentityOperand(node.GetOperation(), *lhsValue, false)) {
+            m_Result = std::move(rhs);
+        } else {
+            m_Result = std::move(self);
+            return;
+        }
+
+        m_SimplifiedNodes++;
+    }
+
+    // numbers and errors stay as they are
+    void ConstantFolder::Visit(const NumberExprAST& node) {}
+
+    void ConstantFolder::Visit(const ProgramAST& node) {
+        std::unique_ptr<GenericASTNode> self = std::move(m_Result);
+
+        for (std::unique_ptr<GenericASTNode>& expression : llvm::cast<ProgramAST>(*self).GetMutableExpressions()) {
+            expression = Fold(std::move(expression));
+        }
+
+        m_Result = std::move(self);
+    }
+
+    void ConstantFolder::Visit(const ErrorAST& node) {}
+
+}  // namespace optiz::fe
+
+// Two's complement wrap-around, computed on unsigned values to stay clear of
+// signed overflow in the compiler itself.
+static std::optional<int> evaluateUnary(optiz::fe::TokenType operation, int operand) {
+    using optiz::fe::TokenType;
+
+    switch (operation) {
+        case TokenType::Plus: return operand;
+        case TokenType::Minus: return static_cast<int>(0u - static_cast<uint32_t>(operand));
+        default: return std::nullopt;
+    }
+}
+
+static std::optional<int> evaluateBinary(optiz::fe::TokenType operation, int lhs, int rhs) {
+    using optiz::fe::TokenType;
+
+    uint32_t left  = static_cast<uint32_t>(lhs);
+    uint32_t right = static_cast<uint32_t>(rhs);
+
+    switch (operation) {
+        case TokenType::Plus: return static_cast<int>(left + right);
+        case TokenType::Minus: return static_cast<int>(left - right);
+        case TokenType::Star: return static_cast<int>(left * right);
+        case TokenType::Slash:
+            // a run-time error in both tiers, leave it to run time
+            if (rhs == 0 || (lhs == std::numeric_limits<int>::min() && rhs == -1)) {
+                return std::nullopt;
+            }
+            return lhs / rhs;
+        default: return std::nullopt;
+    }
+}
+
+static std::optional<int> getConstant(const optiz::fe::GenericASTNode& node) {
+    if (const auto* number = llvm::dyn_cast<optiz::fe::NumberExprAST>(&node)) {
+        return number->GetValue();
+    }
+
+    return std::nullopt;
+}
+
+// Whether `value` on the given side leaves the other operand unchanged.
+static bool isIdentityOperand(optiz::fe::TokenType operation, int value, bool isRHS) {
+    using optiz::fe::TokenType;
+
+    switch (operation) {
+        case TokenType::Plus: return value == 0;
+        case TokenType::Minus: return isRHS && value == 0;
+        case TokenType::Star: return value == 1;
+        case TokenType::Slash: return isRHS && value == 1;
+        default: return false;
+    }
+}
@@ -3,15 +3,17 @@
 #include <iostream>
 #include <ostream>
 
+#include "fe/Statistics.hpp"
+
 #define MAX_ERRORS 20
 
-static std::ostream& getOutputStream(optiz::fe::DiagnosticLevel level);
 static void printLabel(optiz::fe::DiagnosticLevel level, std::ostream& out);
 
 namespace optiz::fe {
 
     void Diagnostic::Print() const {
-        std::ostream& out = getOutputStream(m_Level);
+        // all levels, so diagnostics never mix with emitted code or program output
+        std::ostream& out = std::cerr;
 
         out << "[" << m_Location.m_File << ":" << m_Location.m_Line << ":" << m_Location.m_Column << "] ";
 
@@ -20,10 +22,15 @@ namespace optiz::fe {
         out << ": " << m_Message << std::endl;
     }
 
+    DiagnosticEngine::DiagnosticEngine() : DiagnosticEngine(MAX_ERRORS) {}
+
+    DiagnosticEngine::DiagnosticEngine(size_t maxErrors) : m_MaxErrors(maxErrors) {}
+
     void DiagnosticEngine::Report(SrcLocation loc, std::string msg, DiagnosticLevel level) {
         m_ErrorsOccured = m_ErrorsOccured || level >= DiagnosticLevel::Error;
 
         Diagnostic diagnostic = { loc, msg, level };
+        OPTIZ_STAT(CountDiagnostic(diagnostic));
 
         if (level == DiagnosticLevel::Fatal) {
             m_Reports.insert(m_Reports.begin(), diagnostic);
@@ -33,7 +40,8 @@ namespace optiz::fe {
         }
         m_Reports.push_back(diagnostic);
 
-        if (m_Reports.size() > MAX_ERRORS) {
+        // infos and warnings, e.g. optimization remarks, don't count
+        if (level >= DiagnosticLevel::Error && ++m_ErrorCount > m_MaxErrors && m_MaxErrors != 0) {
             Report(loc, "Too many errors, aborting...", DiagnosticLevel::Fatal);
         }
     }
@@ -44,6 +52,16 @@ namespace optiz::fe {
         }
     }
 
+    void DiagnosticEngine::Clear() {
+        m_Reports.clear();
+    }
+
+    void DiagnosticEngine::Reset() {
+        m_Reports.clear();
+        m_ErrorCount    = 0;
+        m_ErrorsOccured = false;
+    }
+
     bool DiagnosticEngine::HasReports() const {
         return !m_Reports.empty();
     }
@@ -51,23 +69,11 @@ namespace optiz::fe {
         return m_ErrorsOccured;
     }
 
-}  // namespace optiz::fe
-
-static std::ostream& getOutputStream(optiz::fe::DiagnosticLevel level) {
-    using optiz::fe::DiagnosticLevel;
-
-    switch (level) {
-        case DiagnosticLevel::Info:
-        case DiagnosticLevel::Warning:
-            return std::cout;
-
-        case DiagnosticLevel::Error:
-        case DiagnosticLevel::Fatal:
-            return std::cerr;
+    const std::vector<Diagnostic>& DiagnosticEngine::GetReports() const {
+        return m_Reports;
     }
 
-    return std::cout;
-}
+}  // namespace optiz::fe
 
 static void printLabel(optiz::fe::DiagnosticLevel level, std::ostream& out) {
     using optiz::fe::DiagnosticLevel;
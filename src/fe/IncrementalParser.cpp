@@ -0,0 +1,474 @@
+#include "fe/IncrementalParser.hpp"
+
+#include <llvm/Support/Casting.h>
+#include <llvm/Support/ErrorHandling.h>
+
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+#include "fe/Parser.hpp"
+
+// How far a piece of text moves a location: its bytes, its newlines, and the
+// columns it adds to the line it starts in (without newlines) or the column it
+// ends in (with newlines).
+struct TextExtent {
+    uint m_Bytes  = 0;
+    uint m_Lines  = 0;
+    uint m_Column = 0;
+};
+
+static TextExtent getExtent(const optiz::fe::SrcLocation& start, const optiz::fe::SrcLocation& end);
+static TextExtent append(const TextExtent& first, const TextExtent& second);
+static optiz::fe::SrcLocation advance(const optiz::fe::SrcLocation& location, const TextExtent& extent);
+static optiz::fe::SrcLocation translate(const optiz::fe::SrcLocation& location, const optiz::fe::SrcLocation& parsedStart,
+                                        const optiz::fe::SrcLocation& currentStart);
+
+namespace optiz::fe {
+
+    // Implicit treap over the statements in text order. A node's index is the
+    // number of statements before it, and every node sums up the text and the
+    // diagnosed statements of its subtree, so start locations, offset lookups
+    // and range replacements are all found on the way down.
+    class IncrementalParser::StatementTree {
+        struct Node {
+            Statement m_Statement;
+            TextExtent m_StatementExtent;
+            uint32_t m_Priority;
+
+            // of the whole subtree
+            size_t m_Size;
+            size_t m_DiagnosedCount;
+            TextExtent m_Extent;
+
+            std::unique_ptr<Node> m_Left;
+            std::unique_ptr<Node> m_Right;
+        };
+
+        std::unique_ptr<Node> m_Root;
+        std::minstd_rand m_Random;
+
+    public:
+        size_t GetSize() const {
+            return SizeOf(m_Root);
+        }
+
+        size_t GetDiagnosedCount() const {
+            return m_Root ? m_Root->m_DiagnosedCount : 0;
+        }
+
+        const Statement& Get(size_t index) const {
+            const Node* node = m_Root.get();
+
+            while (index != SizeOf(node->m_Left)) {
+                if (index < SizeOf(node->m_Left)) {
+                    node = node->m_Left.get();
+                } else {
+                    index -= SizeOf(node->m_Left) + 1;
+                    node = node->m_Right.get();
+                }
+            }
+
+            return node->m_Statement;
+        }
+
+        // Where statement `index` starts in the current text, GetSize() gives the
+        // end of the last statement.
+        SrcLocation GetStart(size_t index, const SrcLocation& textStart) const {
+            TextExtent before;
+            const Node* node = m_Root.get();
+
+            while (node) {
+                if (index < SizeOf(node->m_Left)) {
+                    node = node->m_Left.get();
+                    continue;
+                }
+
+                before = append(before, ExtentOf(node->m_Left));
+                if (index == SizeOf(node->m_Left)) {
+                    break;
+                }
+
+                before = append(before, node->m_StatementExtent);
+                index -= SizeOf(node->m_Left) + 1;
+                node = node->m_Right.get();
+            }
+
+            return advance(textStart, before);
+        }
+
+        // Index of the statement whose text contains `offset`, the last one if
+        // the offset lies past all of them.
+        size_t Find(uint offset) const {
+            size_t index     = 0;
+            const Node* node = m_Root.get();
+
+            while (node) {
+                uint leftBytes = ExtentOf(node->m_Left).m_Bytes;
+                if (offset < leftBytes) {
+                    node = node->m_Left.get();
+                    continue;
+                }
+
+                offset -= leftBytes;
+                index += SizeOf(node->m_Left);
+
+                if (offset < node->m_StatementExtent.m_Bytes) {
+                    return index;
+                }
+
+                offset -= node->m_StatementExtent.m_Bytes;
+                index++;
+                node = node->m_Right.get();
+            }
+
+            return index == 0 ? 0 : index - 1;
+        }
+
+        // Replaces the statements [first, last).
+        void Replace(size_t first, size_t last, std::vector<Statement> statements) {
+            auto [before, rest]    = Split(std::move(m_Root), first);
+            auto [replaced, after] = Split(std::move(rest), last - first);
+
+            for (Statement& statement : statements) {
+                auto node               = std::make_unique<Node>();
+                node->m_StatementExtent = getExtent(statement.m_ParsedStart, statement.m_ParsedEnd);
+                node->m_Statement       = std::move(statement);
+                node->m_Priority        = m_Random();
+                Update(*node);
+
+                before = Merge(std::move(before), std::move(node));
+            }
+
+            m_Root = Merge(std::move(before), std::move(after));
+        }
+
+        // Calls `callback(statement, start)` for every statement in text order.
+        template <typename Callback>
+        void ForEach(const SrcLocation& textStart, Callback callback) const {
+            SrcLocation start = textStart;
+            ForEachIn(m_Root.get(), start, callback);
+        }
+
+    private:
+        static size_t SizeOf(const std::unique_ptr<Node>& node) {
+            return node ? node->m_Size : 0;
+        }
+
+        static TextExtent ExtentOf(const std::unique_ptr<Node>& node) {
+            return node ? node->m_Extent : TextExtent{};
+        }
+
+        static void Update(Node& node) {
+            node.m_Size           = SizeOf(node.m_Left) + 1 + SizeOf(node.m_Right);
+            node.m_DiagnosedCount = (node.m_Left ? node.m_Left->m_DiagnosedCount : 0) + node.m_Statement.m_HasDiagnostics +
+                                    (node.m_Right ? node.m_Right->m_DiagnosedCount : 0);
+            node.m_Extent         = append(append(ExtentOf(node.m_Left), node.m_StatementExtent), ExtentOf(node.m_Right));
+        }
+
+        // The first `count` statements, and the rest.
+        static std::pair<std::unique_ptr<Node>, std::unique_ptr<Node>> Split(std::unique_ptr<Node> node, size_t count) {
+            if (!node) {
+                return {};
+            }
+
+            if (count <= SizeOf(node->m_Left)) {
+                auto [left, right] = Split(std::move(node->m_Left), count);
+                node->m_Left       = std::move(right);
+                Update(*node);
+                return { std::move(left), std::move(node) };
+            }
+
+            auto [left, right] = Split(std::move(node->m_Right), count - SizeOf(node->m_Left) - 1);
+            node->m_Right      = std::move(left);
+            Update(*node);
+            return { std::move(node), std::move(right) };
+        }
+
+        static std::unique_ptr<Node> Merge(std::unique_ptr<Node> left, std::unique_ptr<Node> right) {
+            if (!left || !right) {
+                return left ? std::move(left) : std::move(right);
+            }
+
+            if (left->m_Priority > right->m_Priority) {
+                left->m_Right = Merge(std::move(left->m_Right), std::move(right));
+                Update(*left);
+                return left;
+            }
+
+            right->m_Left = Merge(std::move(left), std::move(right->m_Left));
+            Update(*right);
+            return right;
+        }
+
+        template <typename Callback>
+        static void ForEachIn(const Node* node, SrcLocation& start, Callback& callback) {
+            if (!node) {
+                return;
+            }
+
+            ForEachIn(node->m_Left.get(), start, callback);
+            callback(node->m_Statement, start);
+            start = advance(start, node->m_StatementExtent);
+            ForEachIn(node->m_Right.get(), start, callback);
+        }
+    };
+
+    // Copies an AST, moving every location from where it was parsed to where
+    // its statement starts now.
+    class LocationTranslator : public ASTVisitor {
+        const SrcLocation& m_ParsedStart;
+        const SrcLocation& m_CurrentStart;
+        std::unique_ptr<GenericASTNode> m_Result;
+
+    public:
+        LocationTranslator(const SrcLocation& parsedStart, const SrcLocation& currentStart)
+            : m_ParsedStart(parsedStart), m_CurrentStart(currentStart) {}
+
+        std::unique_ptr<GenericASTNode> Translate(const GenericASTNode& node) {
+            node.accept(*this);
+            return std::move(m_Result);
+        }
+
+    private:
+        void Visit(const UnaryExprAST& node) override {
+            auto expression = Translate(*node.GetExpr());
+            m_Result        = std::make_unique<UnaryExprAST>(node.getOperation(), std::move(expression), GetStart(node), GetEnd(node));
+        }
+
+        void Visit(const BinaryExprAST& node) override {
+            auto lhs = Translate(*node.GetLHS());
+            auto rhs = Translate(*node.GetRHS());
+            m_Result = std::make_unique<BinaryExprAST>(std::move(lhs), std::move(rhs), node.GetOperation(), GetStart(node), GetEnd(node));
+        }
+
+        void Visit(const NumberExprAST& node) override {
+            m_Result = std::make_unique<NumberExprAST>(node.GetValue(), GetStart(node), GetEnd(node));
+        }
+
+        void Visit(const ProgramAST& node) override {
+            llvm_unreachable("programs are not statements");
+        }
+
+        void Visit(const ErrorAST& node) override {
+            m_Result = std::make_unique<ErrorAST>();
+        }
+
+        SrcLocation GetStart(const GenericASTNode& node) const {
+            return translate(node.GetStartLocation(), m_ParsedStart, m_CurrentStart);
+        }
+
+        SrcLocation GetEnd(const GenericASTNode& node) const {
+            return translate(node.GetEndLocation(), m_ParsedStart, m_CurrentStart);
+        }
+    };
+
+    // A session outlives any single parse, so its engine never aborts on too
+    // many errors and starts over with every edit.
+    IncrementalParser::IncrementalParser(std::string text, std::string file)
+        : m_File(std::move(file)),
+          m_DiagnosticEngine(0),
+          m_Statements(std::make_unique<StatementTree>()),
+          m_TailHasDiagnostics(false),
+          m_ReparsedCount(0) {
+        ApplyEdit(TextEdit{ 0, 0, std::move(text) });
+    }
+
+    IncrementalParser::~IncrementalParser() = default;
+
+    void IncrementalParser::ApplyEdit(const TextEdit& edit) {
+        assert(edit.m_Offset + edit.m_Length <= m_Text.size() && "edit out of range");
+
+        size_t count      = m_Statements->GetSize();
+        size_t first      = m_Statements->Find(edit.m_Offset);
+        SrcLocation start = m_Statements->GetStart(first, SrcLocation{ 1, 1, m_File });
+        uint oldEditEnd   = edit.m_Offset + edit.m_Length;
+        uint newEditEnd   = edit.m_Offset + edit.m_Replacement.size();
+        int64_t delta     = static_cast<int64_t>(edit.m_Replacement.size()) - edit.m_Length;
+
+        m_Text.replace(edit.m_Offset, edit.m_Length, edit.m_Replacement);
+        m_DiagnosticEngine.Reset();
+
+        Parser parser(m_Text, start, m_DiagnosticEngine);
+        std::vector<Statement> reparsed;
+        size_t next         = first;
+        size_t last         = count;  // one past the last replaced statement
+        bool resynchronized = false;
+
+        while (!parser.IsAtEnd()) {
+            SrcLocation statementStart = parser.GetPreviousTokenEnd();
+            std::unique_ptr<GenericASTNode> node = parser.ParseTopLevelStatement();
+            reparsed.push_back(Statement{ statementStart, parser.GetPreviousTokenEnd(), std::move(node), false });
+
+            uint end = reparsed.back().m_ParsedEnd.m_Offset;
+            if (end < newEditEnd) {
+                continue;
+            }
+
+            // past the edit, the text is unchanged and the lexer restarts from a
+            // clean state after every ';', so ending where an old statement
+            // ended means everything after it can be kept
+            while (next < count) {
+                uint oldEnd = GetCurrentEnd(next).m_Offset;
+
+                if (oldEnd < oldEditEnd || oldEnd + delta < end) {
+                    next++;
+                    continue;
+                }
+
+                if (oldEnd + delta == end) {
+                    last           = next + 1;
+                    resynchronized = true;
+                }
+                break;
+            }
+
+            if (resynchronized) {
+                break;
+            }
+        }
+
+        // the lexer reports errors one token ahead, so they are matched to the
+        // statements by location. Past the last re-parsed statement, they belong
+        // to the text after the last statement if the parser got to the end, and
+        // otherwise to a kept statement, which reported them when it was parsed.
+        bool reachedEnd = parser.IsAtEnd();
+        if (reachedEnd) {
+            m_TailHasDiagnostics = false;
+        }
+
+        for (const Diagnostic& diagnostic : m_DiagnosticEngine.GetReports()) {
+            auto statement = std::upper_bound(reparsed.begin(), reparsed.end(), diagnostic.m_Location.m_Offset,
+                                              [](uint offset, const Statement& statement) { return offset < statement.m_ParsedEnd.m_Offset; });
+
+            if (statement != reparsed.end()) {
+                statement->m_HasDiagnostics = true;
+            } else if (reachedEnd) {
+                m_TailHasDiagnostics = true;
+            }
+        }
+
+        m_ReparsedCount = reparsed.size();
+        m_Statements->Replace(std::min(first, count), last, std::move(reparsed));
+    }
+
+    void IncrementalParser::ReplaceText(const std::string& text) {
+        size_t prefix    = std::mismatch(text.begin(), text.end(), m_Text.begin(), m_Text.end()).first - text.begin();
+        size_t maxSuffix = std::min(text.size(), m_Text.size()) - prefix;
+
+        size_t suffix = 0;
+        while (suffix < maxSuffix && text[text.size() - suffix - 1] == m_Text[m_Text.size() - suffix - 1]) {
+            suffix++;
+        }
+
+        if (prefix == text.size() && prefix == m_Text.size()) {
+            m_ReparsedCount = 0;
+            m_DiagnosticEngine.Reset();
+            return;
+        }
+
+        ApplyEdit(TextEdit{ static_cast<uint>(prefix), static_cast<uint>(m_Text.size() - prefix - suffix),
+                            text.substr(prefix, text.size() - prefix - suffix) });
+    }
+
+    const DiagnosticEngine& IncrementalParser::GetDiagnostics() const {
+        return m_DiagnosticEngine;
+    }
+
+    bool IncrementalParser::HasDiagnostics() const {
+        return m_Statements->GetDiagnosedCount() != 0 || m_TailHasDiagnostics;
+    }
+
+    const std::string& IncrementalParser::GetText() const {
+        return m_Text;
+    }
+
+    const std::string& IncrementalParser::GetFile() const {
+        return m_File;
+    }
+
+    size_t IncrementalParser::GetStatementCount() const {
+        return m_Statements->GetSize();
+    }
+
+    const GenericASTNode& IncrementalParser::GetStatement(size_t index) const {
+        return *m_Statements->Get(index).m_Node;
+    }
+
+    SrcLocation IncrementalParser::TranslateLocation(size_t index, const SrcLocation& location) const {
+        return translate(location, m_Statements->Get(index).m_ParsedStart, m_Statements->GetStart(index, SrcLocation{ 1, 1, m_File }));
+    }
+
+    std::unique_ptr<ProgramAST> IncrementalParser::BuildProgram() const {
+        std::vector<std::unique_ptr<GenericASTNode>> expressions;
+
+        m_Statements->ForEach(SrcLocation{ 1, 1, m_File }, [&](const Statement& statement, const SrcLocation& start) {
+            if (!llvm::isa<ErrorAST>(*statement.m_Node)) {
+                expressions.push_back(LocationTranslator(statement.m_ParsedStart, start).Translate(*statement.m_Node));
+            }
+        });
+
+        SrcLocation startLocation, endLocation;
+
+        if (expressions.empty()) {
+            // like the parser, an empty program sits at the end of the text,
+            // after anything the lexer skips
+            DiagnosticEngine diagnosticEngine(0);
+            Lexer lexer(m_Text, m_Statements->GetStart(m_Statements->GetSize(), SrcLocation{ 1, 1, m_File }), diagnosticEngine);
+            Token token;
+
+            do {
+                token = lexer.GetNextToken();
+            } while (token != TokenType::EndOfFile);
+
+            startLocation = endLocation = token.m_StartLocation;
+        } else {
+            startLocation = expressions.front()->GetStartLocation();
+            endLocation   = expressions.back()->GetEndLocation();
+        }
+
+        return std::make_unique<ProgramAST>(std::move(expressions), startLocation, endLocation);
+    }
+
+    size_t IncrementalParser::GetReparsedCount() const {
+        return m_ReparsedCount;
+    }
+
+    SrcLocation IncrementalParser::GetCurrentEnd(size_t index) const {
+        return m_Statements->GetStart(index + 1, SrcLocation{ 1, 1, m_File });
+    }
+
+}  // namespace optiz::fe
+
+static TextExtent getExtent(const optiz::fe::SrcLocation& start, const optiz::fe::SrcLocation& end) {
+    uint lines = end.m_Line - start.m_Line;
+    return TextExtent{ end.m_Offset - start.m_Offset, lines, lines == 0 ? end.m_Column - start.m_Column : end.m_Column };
+}
+
+static TextExtent append(const TextExtent& first, const TextExtent& second) {
+    return TextExtent{ first.m_Bytes + second.m_Bytes, first.m_Lines + second.m_Lines,
+                       second.m_Lines == 0 ? first.m_Column + second.m_Column : second.m_Column };
+}
+
+static optiz::fe::SrcLocation advance(const optiz::fe::SrcLocation& location, const TextExtent& extent) {
+    optiz::fe::SrcLocation advanced = location;
+    advanced.m_Offset += extent.m_Bytes;
+    advanced.m_Line += extent.m_Lines;
+    advanced.m_Column = extent.m_Lines == 0 ? location.m_Column + extent.m_Column : extent.m_Column;
+
+    return advanced;
+}
+
+// A statement's own text is unchanged, only its start moved.
+static optiz::fe::SrcLocation translate(const optiz::fe::SrcLocation& location, const optiz::fe::SrcLocation& parsedStart,
+                                        const optiz::fe::SrcLocation& currentStart) {
+    optiz::fe::SrcLocation translated = location;
+    translated.m_Offset               = location.m_Offset - parsedStart.m_Offset + currentStart.m_Offset;
+    translated.m_Line                 = location.m_Line - parsedStart.m_Line + currentStart.m_Line;
+
+    if (location.m_Line == parsedStart.m_Line) {
+        translated.m_Column = location.m_Column - parsedStart.m_Column + currentStart.m_Column;
+    }
+
+    return translated;
+}
@@ -1,8 +1,11 @@
 #include "fe/Lexer.hpp"
 
+#include <llvm/Support/TimeProfiler.h>
+
 #include <unordered_map>
 
 #include "fe/Diagnostic.hpp"
+#include "fe/Statistics.hpp"
 
 using optiz::fe::TokenType;
 
@@ -40,10 +43,26 @@ namespace optiz::fe {
     Token::Token(TokenType type, std::string lexeme, SrcLocation startLocation, SrcLocation endLocation)
         : m_Type(type), m_Lexeme(lexeme), m_StartLocation(startLocation), m_EndLocation(endLocation) {}
 
-    Lexer::Lexer(const std::string& input, const std::string& file, DiagnosticEngine& diagnosticEngine)
-        : m_Input(input), m_Cursor(0), m_Location(SrcLocation{ 1, 1, file }), m_Current(input[m_Cursor]), m_DiagnosticEngine(diagnosticEngine) {}
+    Lexer::Lexer(std::string_view input, const std::string& file, DiagnosticEngine& diagnosticEngine)
+        : Lexer(input, SrcLocation{ 1, 1, file }, diagnosticEngine) {}
+
+    Lexer::Lexer(std::string_view input, SrcLocation start, DiagnosticEngine& diagnosticEngine)
+        : m_Input(input),
+          m_Cursor(start.m_Offset),
+          m_Location(start),
+          m_Current(m_Cursor < input.size() ? input[m_Cursor] : '\0'),
+          m_DiagnosticEngine(diagnosticEngine) {}
 
     Token Lexer::GetNextToken() {
+        llvm::TimeTraceScope scope("Lex");
+
+        Token token = Tokenize();
+        OPTIZ_STAT(CountToken(token));
+
+        return token;
+    }
+
+    Token Lexer::Tokenize() {
         SkipWhitespace();
 
         if (m_Current == '\0') {
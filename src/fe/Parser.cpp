@@ -1,6 +1,8 @@
 #include "fe/Parser.hpp"
 
+#include <llvm/ADT/StringRef.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include <memory>
 #include <string>
@@ -19,31 +21,25 @@ int getPrecedence(optiz::fe::TokenType operation);
 
 namespace optiz::fe {
 
-    Parser::Parser(const std::string& input, const std::string& file, DiagnosticEngine& diagnosticEngine)
-        : m_Lexer(input, file, diagnosticEngine), m_DiagnosticEngine(diagnosticEngine) {
+    Parser::Parser(std::string_view input, const std::string& file, DiagnosticEngine& diagnosticEngine)
+        : Parser(input, SrcLocation{ 1, 1, file }, diagnosticEngine) {}
+
+    Parser::Parser(std::string_view input, SrcLocation start, DiagnosticEngine& diagnosticEngine)
+        : m_DiagnosticEngine(diagnosticEngine), m_Lexer(input, start, diagnosticEngine), m_PanicModeEnabled(false) {
         Advance();
+        m_PreviousTokenEnd = start;
     }
 
     // PROGRAM ::= ( EXPRESSION ';' )*
     std::unique_ptr<GenericASTNode> Parser::ParseProgram() {
-        std::vector<std::unique_ptr<GenericASTNode>> expressions;
-        while (m_CurrentToken.m_Type != TokenType::EndOfFile) {
-            m_PanicModeEnabled = false;
+        llvm::TimeTraceScope scope("ParseProgram");
 
-            std::unique_ptr<GenericASTNode> expression = ParseExpression();
-            if (llvm::isa<ErrorAST>(expression)) {
-                Synchronize();
-                continue;
-            }
-
-            if (m_CurrentToken.m_Type != TokenType::SemiColon) {
-                ReportError(m_CurrentToken.m_StartLocation, "Expected ';'");
-                Synchronize();
-                continue;
+        std::vector<std::unique_ptr<GenericASTNode>> expressions;
+        while (!IsAtEnd()) {
+            std::unique_ptr<GenericASTNode> expression = ParseTopLevelStatement();
+            if (!llvm::isa<ErrorAST>(expression)) {
+                expressions.push_back(std::move(expression));
             }
-
-            Advance();
-            expressions.push_back(std::move(expression));
         }
 
         SrcLocation startLocation, endLocation;
@@ -58,36 +54,54 @@ namespace optiz::fe {
         return std::make_unique<ProgramAST>(std::move(expressions), startLocation, endLocation);
     }
 
-    // EXPRESSION ::= UNARY BINOPRHS
-    std::unique_ptr<GenericASTNode> Parser::ParseExpression() {
-        auto lhs = ParseUnary();
-        if (!lhs) {
+    std::unique_ptr<GenericASTNode> Parser::ParseTopLevelStatement() {
+        llvm::TimeTraceScope scope("ParseTopLevelStatement", [this] {
+            const SrcLocation& location = m_CurrentToken.m_StartLocation;
+            return location.m_File + ":" + std::to_string(location.m_Line) + ":" + std::to_string(location.m_Column);
+        });
+
+        m_PanicModeEnabled = false;
+
+        std::unique_ptr<GenericASTNode> expression = ParseExpression();
+        if (llvm::isa<ErrorAST>(expression)) {
+            Synchronize();
+            return expression;
+        }
+
+        if (m_CurrentToken.m_Type != TokenType::SemiColon) {
+            ReportError(m_CurrentToken.m_StartLocation, "Expected ';'");
+            Synchronize();
             return std::make_unique<ErrorAST>();
         }
 
-        return ParseBinOpRHS(std::move(lhs), NEUTRAL_PRECEDENCE);
+        Advance();
+        return expression;
     }
 
-    // UNARY ::= PRIMARY | ('+' | '-') UNARY
-    std::unique_ptr<GenericASTNode> Parser::ParseUnary() {
-        if (!isSupportedUnaryOperation(m_CurrentToken.m_Type)) {
-            return ParsePrimary();
-        }
+    bool Parser::IsAtEnd() const {
+        return m_CurrentToken.m_Type == TokenType::EndOfFile;
+    }
 
-        TokenType op              = m_CurrentToken.m_Type;
-        SrcLocation startLocation = m_CurrentToken.m_StartLocation;
-        Advance();
+    const SrcLocation& Parser::GetPreviousTokenEnd() const {
+        return m_PreviousTokenEnd;
+    }
 
-        auto rhs = ParseUnary();
-        if (!rhs) {
-            return std::make_unique<ErrorAST>();
+    // EXPRESSION ::= BINARY_EXPR
+    std::unique_ptr<GenericASTNode> Parser::ParseExpression() {
+        return ParseBinaryExpression();
+    }
+
+    // BINARY_EXPR ::= UNARY (BIN_OPERATOR UNARY)*
+    std::unique_ptr<GenericASTNode> Parser::ParseBinaryExpression() {
+        auto lhs = ParseUnaryExpression();
+        if (llvm::isa<ErrorAST>(lhs)) {
+            return lhs;
         }
 
-        return std::make_unique<UnaryExprAST>(op, std::move(rhs), startLocation, rhs->GetEndLocation());
+        return ParseBinaryOperationRHS(std::move(lhs), NEUTRAL_PRECEDENCE);
     }
 
-    // BINOPRHS ::= ( ('+' | '-' | '*' | '/') UNARY )*
-    std::unique_ptr<GenericASTNode> Parser::ParseBinOpRHS(std::unique_ptr<GenericASTNode> lhs, int originalPrecedence) {
+    std::unique_ptr<GenericASTNode> Parser::ParseBinaryOperationRHS(std::unique_ptr<GenericASTNode> lhs, int originalPrecedence) {
         while (true) {
             int precedence = getPrecedence(m_CurrentToken.m_Type);
             if (precedence < originalPrecedence) {
@@ -97,16 +111,16 @@ namespace optiz::fe {
             TokenType op = m_CurrentToken.m_Type;
             Advance();
 
-            auto rhs = ParseUnary();
-            if (!rhs) {
-                return std::make_unique<ErrorAST>();
+            auto rhs = ParseUnaryExpression();
+            if (llvm::isa<ErrorAST>(rhs)) {
+                return rhs;
             }
 
             int nextPrecedence = getPrecedence(m_CurrentToken.m_Type);
             if (precedence < nextPrecedence) {
-                rhs = ParseBinOpRHS(std::move(rhs), nextPrecedence);
-                if (!rhs) {
-                    return std::make_unique<ErrorAST>();
+                rhs = ParseBinaryOperationRHS(std::move(rhs), precedence + 1);
+                if (llvm::isa<ErrorAST>(rhs)) {
+                    return rhs;
                 }
             }
 
@@ -115,26 +129,44 @@ namespace optiz::fe {
 
             lhs = std::make_unique<BinaryExprAST>(std::move(lhs), std::move(rhs), op, startLocation, endLocation);
         }
+    }
 
-        while (isSupportedBinaryOperation(m_CurrentToken.m_Type)) {
-            TokenType op = m_CurrentToken.m_Type;
-            Advance();
-
-            auto rhs = ParsePrimary();
-            if (!rhs)
-                return std::make_unique<ErrorAST>();
+    // UNARY ::= UN_OPERATOR UNARY | PRIMARY_EXPRESSION
+    std::unique_ptr<GenericASTNode> Parser::ParseUnaryExpression() {
+        if (!isSupportedUnaryOperation(m_CurrentToken.m_Type)) {
+            return ParsePrimaryExpression();
+        }
 
-            SrcLocation startLocation = lhs->GetStartLocation();
-            SrcLocation endLocation   = rhs->GetEndLocation();
+        TokenType op              = m_CurrentToken.m_Type;
+        SrcLocation startLocation = m_CurrentToken.m_StartLocation;
+        Advance();
 
-            lhs = std::make_unique<BinaryExprAST>(std::move(lhs), std::move(rhs), op, startLocation, endLocation);
+        auto rhs = ParseUnaryExpression();
+        if (llvm::isa<ErrorAST>(rhs)) {
+            return rhs;
         }
-        return lhs;
+
+        SrcLocation endLocation = rhs->GetEndLocation();
+        return std::make_unique<UnaryExprAST>(op, std::move(rhs), startLocation, endLocation);
     }
 
-    std::unique_ptr<GenericASTNode> Parser::ParsePrimary() {
+    // PRIMARY_EXPRESSION ::= <number> | '(' EXPRESSION ')'
+    std::unique_ptr<GenericASTNode> Parser::ParsePrimaryExpression() {
         if (m_CurrentToken.m_Type == TokenType::Number) {
-            double value              = std::stod(m_CurrentToken.m_Lexeme);
+            llvm::StringRef lexeme = m_CurrentToken.m_Lexeme;
+
+            // the lexer already knows decimals, the language does not yet
+            if (lexeme.contains('.')) {
+                ReportError(m_CurrentToken.m_StartLocation, "Expected an integer, found '" + lexeme.str() + "'");
+                return std::make_unique<ErrorAST>();
+            }
+
+            int value;
+            if (lexeme.getAsInteger(10, value)) {
+                ReportError(m_CurrentToken.m_StartLocation, "Integer literal '" + lexeme.str() + "' does not fit in 32 bits");
+                return std::make_unique<ErrorAST>();
+            }
+
             SrcLocation startLocation = m_CurrentToken.m_StartLocation;
             SrcLocation endLocation   = m_CurrentToken.m_EndLocation;
             Advance();
@@ -146,8 +178,9 @@ namespace optiz::fe {
         if (m_CurrentToken.m_Type == TokenType::LParen) {
             Advance();
             auto expr = ParseExpression();
-            if (!expr)
-                return std::make_unique<ErrorAST>();
+            if (llvm::isa<ErrorAST>(expr)) {
+                return expr;
+            }
 
             if (m_CurrentToken.m_Type != TokenType::RParen) {
                 ReportError(m_CurrentToken.m_StartLocation, "Expected ')'");
@@ -162,6 +195,8 @@ namespace optiz::fe {
     }
 
     void Parser::Advance() {
+        m_PreviousTokenEnd = m_CurrentToken.m_EndLocation;
+
         do {
             m_CurrentToken = m_Lexer.GetNextToken();
         } while (m_CurrentToken.m_Type == TokenType::Error);
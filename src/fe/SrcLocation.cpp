@@ -3,6 +3,8 @@
 namespace optiz::fe {
 
     void SrcLocation::advance(char current) {
+        m_Offset++;
+
         if (current == '\n') {
             m_Line++;
             m_Column = 0;
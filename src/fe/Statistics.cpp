@@ -0,0 +1,101 @@
+#include "fe/Statistics.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+static const char* getNodeKindName(optiz::fe::NodeKind kind);
+static void printRow(std::ostream& out, uint64_t count, const std::string& description);
+
+namespace optiz::fe {
+
+    FrontendStatistics& GetFrontendStatistics() {
+        static FrontendStatistics s_Statistics;
+        return s_Statistics;
+    }
+
+    void CountToken(const Token& token) {
+        FrontendStatistics& statistics = GetFrontendStatistics();
+
+        statistics.m_Tokens[static_cast<size_t>(token.m_Type)]++;
+        statistics.m_LexemeBytes += token.m_Lexeme.size();
+        statistics.m_LexemeHeapBytes += GetHeapBytes(token.m_Lexeme);
+        statistics.m_FileNameCopies += 2;
+        statistics.m_FileNameHeapBytes += GetHeapBytes(token.m_StartLocation.m_File) + GetHeapBytes(token.m_EndLocation.m_File);
+    }
+
+    void CountNode(const GenericASTNode& node, size_t size) {
+        FrontendStatistics& statistics = GetFrontendStatistics();
+        size_t kind                    = static_cast<size_t>(node.GetKind());
+
+        statistics.m_Nodes[kind]++;
+        statistics.m_NodeBytes[kind] += size;
+        statistics.m_FileNameCopies += 2;
+        statistics.m_FileNameHeapBytes += GetHeapBytes(node.GetStartLocation().m_File) + GetHeapBytes(node.GetEndLocation().m_File);
+    }
+
+    void CountDiagnostic(const Diagnostic& diagnostic) {
+        FrontendStatistics& statistics = GetFrontendStatistics();
+
+        statistics.m_Diagnostics++;
+        statistics.m_DiagnosticBytes += sizeof(Diagnostic) + GetHeapBytes(diagnostic.m_Message) + GetHeapBytes(diagnostic.m_Location.m_File);
+    }
+
+    size_t GetHeapBytes(const std::string& string) {
+        static const size_t s_InlineCapacity = std::string().capacity();
+
+        return string.capacity() > s_InlineCapacity ? string.capacity() + 1 : 0;
+    }
+
+    void PrintFrontendStatistics(std::ostream& out) {
+        const FrontendStatistics& statistics = GetFrontendStatistics();
+
+        out << "===-------------------------------------------------------------------------===\n"
+            << "                          ... Frontend Statistics ...\n"
+            << "===-------------------------------------------------------------------------===\n\n";
+
+        for (size_t type = 0; type < TOKEN_TYPE_COUNT; type++) {
+            if (statistics.m_Tokens[type] != 0) {
+                std::ostringstream description;
+                description << "lexer - Number of " << static_cast<TokenType>(type) << " tokens";
+                printRow(out, statistics.m_Tokens[type], description.str());
+            }
+        }
+
+        printRow(out, statistics.m_LexemeBytes, "lexer - Bytes of lexeme characters");
+        printRow(out, statistics.m_LexemeHeapBytes, "lexer - Bytes of lexemes allocated on the heap");
+
+        for (size_t kind = 0; kind < NODE_KIND_COUNT; kind++) {
+            if (statistics.m_Nodes[kind] != 0) {
+                const char* name = getNodeKindName(static_cast<NodeKind>(kind));
+                printRow(out, statistics.m_Nodes[kind], std::string("ast - Number of ") + name + " nodes allocated");
+                printRow(out, statistics.m_NodeBytes[kind], std::string("ast - Bytes of ") + name + " nodes allocated");
+            }
+        }
+
+        printRow(out, statistics.m_FileNameCopies, "srcloc - Number of file name copies");
+        printRow(out, statistics.m_FileNameHeapBytes, "srcloc - Bytes of file name copies allocated on the heap");
+        printRow(out, statistics.m_FoldedNodes, "fold - Number of nodes folded to constants");
+        printRow(out, statistics.m_SimplifiedNodes, "fold - Number of nodes removed by identities");
+        printRow(out, statistics.m_Diagnostics, "diag - Number of diagnostics");
+        printRow(out, statistics.m_DiagnosticBytes, "diag - Bytes of diagnostic storage");
+    }
+
+}  // namespace optiz::fe
+
+static const char* getNodeKindName(optiz::fe::NodeKind kind) {
+    using optiz::fe::NodeKind;
+
+    switch (kind) {
+        case NodeKind::ErrorAST: return "ErrorAST";
+        case NodeKind::NumberExprAST: return "NumberExprAST";
+        case NodeKind::UnaryExprAST: return "UnaryExprAST";
+        case NodeKind::BinaryExprAST: return "BinaryExprAST";
+        case NodeKind::ProgramAST: return "ProgramAST";
+    }
+
+    return "unknown";
+}
+
+static void printRow(std::ostream& out, uint64_t count, const std::string& description) {
+    out << std::setw(12) << count << " " << description << "\n";
+}
@@ -0,0 +1,216 @@
+#include "jit/Benchmark.hpp"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// the results are stored here so the calls cannot be dropped
+static volatile int s_Sink;
+
+static std::chrono::nanoseconds runBatch(optiz::jit::UnitFunction function, uint64_t iterations);
+static void printCounter(llvm::raw_ostream& out, const llvm::Optional<double>& value, unsigned width);
+static llvm::json::Value toJSON(const llvm::Optional<double>& value);
+
+namespace optiz::jit {
+
+    // One hardware event, counted in user space for this thread only.
+    class PerfCounter {
+        int m_Fd;
+
+    public:
+        explicit PerfCounter(uint64_t event) {
+            perf_event_attr attributes = {};
+            attributes.type            = PERF_TYPE_HARDWARE;
+            attributes.size            = sizeof(attributes);
+            attributes.config          = event;
+            attributes.disabled        = 1;
+            attributes.exclude_kernel  = 1;
+            attributes.exclude_hv      = 1;
+            attributes.read_format     = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            m_Fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        ~PerfCounter() {
+            if (m_Fd >= 0) {
+                close(m_Fd);
+            }
+        }
+
+        PerfCounter(const PerfCounter&)            = delete;
+        PerfCounter& operator=(const PerfCounter&) = delete;
+
+        void Start() {
+            if (m_Fd >= 0) {
+                ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        // Scaled up when the kernel had to multiplex the counter.
+        llvm::Optional<double> Stop() {
+            if (m_Fd < 0) {
+                return llvm::None;
+            }
+
+            ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+
+            uint64_t values[3];  // value, time enabled, time running
+            if (read(m_Fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+                return llvm::None;
+            }
+
+            return static_cast<double>(values[0]) * values[1] / values[2];
+        }
+    };
+
+    BenchmarkResult RunBenchmark(const std::string& name, UnitFunction function, const BenchmarkOptions& options) {
+        assert(options.m_Samples >= 2 && "a standard deviation needs two samples");
+
+        auto warmupEnd = std::chrono::steady_clock::now() + options.m_WarmupTime;
+
+        // the warmup doubles as calibration: grow the batch until it fills a sample
+        uint64_t iterations = 1;
+        std::chrono::nanoseconds elapsed;
+
+        do {
+            elapsed = runBatch(function, iterations);
+            if (elapsed < options.m_SampleTime) {
+                iterations *= 2;
+            }
+        } while (elapsed < options.m_SampleTime || std::chrono::steady_clock::now() < warmupEnd);
+
+        iterations = std::max<uint64_t>(1, iterations * options.m_SampleTime.count() / std::max<int64_t>(1, elapsed.count()));
+
+        PerfCounter cycles(PERF_COUNT_HW_CPU_CYCLES);
+        PerfCounter instructions(PERF_COUNT_HW_INSTRUCTIONS);
+        PerfCounter cacheMisses(PERF_COUNT_HW_CACHE_MISSES);
+        PerfCounter branchMisses(PERF_COUNT_HW_BRANCH_MISSES);
+
+        std::vector<double> samples;
+
+        for (PerfCounter* counter : { &cycles, &instructions, &cacheMisses, &branchMisses }) {
+            counter->Start();
+        }
+
+        for (unsigned i = 0; i < options.m_Samples; i++) {
+            samples.push_back(static_cast<double>(runBatch(function, iterations).count()) / iterations);
+        }
+
+        HardwareCounters counters;
+        double calls = static_cast<double>(iterations) * options.m_Samples;
+
+        counters.m_Cycles       = cycles.Stop();
+        counters.m_Instructions = instructions.Stop();
+        counters.m_CacheMisses  = cacheMisses.Stop();
+        counters.m_BranchMisses = branchMisses.Stop();
+
+        for (llvm::Optional<double>* counter :
+             { &counters.m_Cycles, &counters.m_Instructions, &counters.m_CacheMisses, &counters.m_BranchMisses }) {
+            if (*counter) {
+                **counter /= calls;
+            }
+        }
+
+        double mean     = 0;
+        double variance = 0;
+
+        for (double sample : samples) {
+            mean += sample / samples.size();
+        }
+        for (double sample : samples) {
+            variance += (sample - mean) * (sample - mean) / std::max<size_t>(1, samples.size() - 1);
+        }
+
+        BenchmarkResult result;
+        result.m_Name              = name;
+        result.m_Iterations        = iterations;
+        result.m_Samples           = options.m_Samples;
+        result.m_MeanNanoseconds   = mean;
+        result.m_StdDevNanoseconds = std::sqrt(variance);
+        result.m_MinNanoseconds    = samples.empty() ? 0 : *std::min_element(samples.begin(), samples.end());
+        result.m_Counters          = counters;
+
+        return result;
+    }
+
+    void PrintBenchmarkResults(const std::vector<BenchmarkResult>& results, llvm::raw_ostream& out) {
+        out << llvm::left_justify("unit", 20);
+        for (auto [column, width] : { std::pair{ "ns/op", 10 }, { "stddev", 10 }, { "min", 10 }, { "iterations", 12 }, { "cycles", 10 },
+                                      { "instructions", 12 }, { "cache-misses", 12 }, { "branch-misses", 13 } }) {
+            out << " " << llvm::right_justify(column, width);
+        }
+        out << "\n";
+
+        for (const BenchmarkResult& result : results) {
+            out << llvm::format("%-20s %10.3f %10.3f %10.3f %12llu", result.m_Name.c_str(), result.m_MeanNanoseconds,
+                                result.m_StdDevNanoseconds, result.m_MinNanoseconds,
+                                static_cast<unsigned long long>(result.m_Iterations));
+
+            printCounter(out, result.m_Counters.m_Cycles, 10);
+            printCounter(out, result.m_Counters.m_Instructions, 12);
+            printCounter(out, result.m_Counters.m_CacheMisses, 12);
+            printCounter(out, result.m_Counters.m_BranchMisses, 13);
+            out << "\n";
+        }
+    }
+
+    void PrintBenchmarkResultsJSON(const std::vector<BenchmarkResult>& results, llvm::raw_ostream& out) {
+        llvm::json::Array benchmarks;
+
+        for (const BenchmarkResult& result : results) {
+            benchmarks.push_back(llvm::json::Object{
+                { "name", result.m_Name },
+                { "iterations", static_cast<int64_t>(result.m_Iterations) },
+                { "samples", static_cast<int64_t>(result.m_Samples) },
+                { "ns_per_op",
+                  llvm::json::Object{ { "mean", result.m_MeanNanoseconds },
+                                      { "stddev", result.m_StdDevNanoseconds },
+                                      { "min", result.m_MinNanoseconds } } },
+                { "counters_per_op",
+                  llvm::json::Object{ { "cycles", toJSON(result.m_Counters.m_Cycles) },
+                                      { "instructions", toJSON(result.m_Counters.m_Instructions) },
+                                      { "cache_misses", toJSON(result.m_Counters.m_CacheMisses) },
+                                      { "branch_misses", toJSON(result.m_Counters.m_BranchMisses) } } },
+            });
+        }
+
+        out << llvm::formatv("{0:2}", llvm::json::Value(llvm::json::Object{ { "benchmarks", std::move(benchmarks) } })) << "\n";
+    }
+
+}  // namespace optiz::jit
+
+static std::chrono::nanoseconds runBatch(optiz::jit::UnitFunction function, uint64_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        s_Sink = function();
+    }
+
+    return std::chrono::steady_clock::now() - start;
+}
+
+static void printCounter(llvm::raw_ostream& out, const llvm::Optional<double>& value, unsigned width) {
+    if (value) {
+        out << " " << llvm::format("%*.2f", width, *value);
+    } else {
+        out << " " << llvm::right_justify("n/a", width);
+    }
+}
+
+static llvm::json::Value toJSON(const llvm::Optional<double>& value) {
+    if (value) {
+        return *value;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,132 @@
+#include "jit/JIT.hpp"
+
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Support/TimeProfiler.h>
+
+namespace optiz::jit {
+
+    // Wraps the default compiler so the time spent generating machine code is
+    // accounted for separately from the time spent running it.
+    class TimedCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+        llvm::orc::TMOwningSimpleCompiler m_Compiler;
+        std::shared_ptr<CompileStats> m_Stats;
+
+    public:
+        TimedCompiler(std::unique_ptr<llvm::TargetMachine> targetMachine, std::shared_ptr<CompileStats> stats)
+            : IRCompiler(llvm::orc::irManglingOptionsFromTargetOptions(targetMachine->Options)),
+              m_Compiler(std::move(targetMachine)),
+              m_Stats(std::move(stats)) {}
+
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module& module) override {
+            llvm::TimeTraceScope scope("JITCompile", module.getName());
+
+            auto start = std::chrono::steady_clock::now();
+            auto object = m_Compiler(module);
+            auto end = std::chrono::steady_clock::now();
+
+            for (const llvm::Function& function : module) {
+                if (!function.isDeclaration()) {
+                    m_Stats->m_Functions++;
+                }
+            }
+            m_Stats->m_Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            return object;
+        }
+    };
+
+    JIT::JIT(std::unique_ptr<PerfMapListener> perfMapListener, std::unique_ptr<llvm::orc::LLLazyJIT> jit,
+             std::shared_ptr<CompileStats> compileStats)
+        : m_PerfMapListener(std::move(perfMapListener)), m_JIT(std::move(jit)), m_CompileStats(std::move(compileStats)) {}
+
+    llvm::Expected<std::unique_ptr<JIT>> JIT::Create(bool perfSupport) {
+        auto compileStats = std::make_shared<CompileStats>();
+
+        llvm::orc::LLLazyJITBuilder jitBuilder;
+        std::unique_ptr<PerfMapListener> perfMapListener;
+
+        if (perfSupport) {
+            perfMapListener = std::make_unique<PerfMapListener>();
+
+            // the same RuntimeDyld layer LLJIT uses by default on ELF, with the listeners attached
+            jitBuilder.setObjectLinkingLayerCreator([listener = perfMapListener.get()](llvm::orc::ExecutionSession& session,
+                                                                                   const llvm::Triple&) {
+                auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+                    session, [] { return std::make_unique<llvm::SectionMemoryManager>(); });
+
+                layer->registerJITEventListener(*listener);
+                if (llvm::JITEventListener* jitdumpListener = llvm::JITEventListener::createPerfJITEventListener()) {
+                    layer->registerJITEventListener(*jitdumpListener);
+                }
+
+                return std::unique_ptr<llvm::orc::ObjectLayer>(std::move(layer));
+            });
+        }
+
+        auto jit = jitBuilder
+                       .setCompileFunctionCreator([compileStats](llvm::orc::JITTargetMachineBuilder builder)
+                                                      -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                           auto targetMachine = builder.createTargetMachine();
+                           if (!targetMachine) {
+                               return targetMachine.takeError();
+                           }
+
+                           return std::make_unique<TimedCompiler>(std::move(*targetMachine), compileStats);
+                       })
+                       .create();
+        if (!jit) {
+            return jit.takeError();
+        }
+
+        // Compile one function at a time instead of the whole module on first call.
+        (*jit)->setPartitionFunction(llvm::orc::CompileOnDemandLayer::compileRequested);
+
+        auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+        if (!generator) {
+            return generator.takeError();
+        }
+        (*jit)->getMainJITDylib().addGenerator(std::move(*generator));
+
+        return std::unique_ptr<JIT>(new JIT(std::move(perfMapListener), std::move(*jit), std::move(compileStats)));
+    }
+
+    llvm::Error JIT::AddLazyModule(llvm::orc::ThreadSafeModule module) {
+        return m_JIT->addLazyIRModule(std::move(module));
+    }
+
+    llvm::Error JIT::AddModule(llvm::orc::ThreadSafeModule module) {
+        return m_JIT->addIRModule(std::move(module));
+    }
+
+    llvm::Expected<llvm::JITTargetAddress> JIT::Lookup(llvm::StringRef name) {
+        auto symbol = m_JIT->lookup(name);
+        if (!symbol) {
+            return symbol.takeError();
+        }
+
+        return symbol->getAddress();
+    }
+
+    llvm::Expected<int> JIT::RunMain() {
+        auto address = Lookup("main");
+        if (!address) {
+            return address.takeError();
+        }
+
+        auto* main = reinterpret_cast<int (*)()>(*address);
+        return main();
+    }
+
+    std::chrono::nanoseconds JIT::GetCompileTime() const {
+        return std::chrono::nanoseconds(m_CompileStats->m_Nanoseconds.load());
+    }
+
+    uint64_t JIT::GetCompiledFunctionCount() const {
+        return m_CompileStats->m_Functions;
+    }
+
+}  // namespace optiz::jit
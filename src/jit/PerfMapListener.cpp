@@ -0,0 +1,54 @@
+#include "jit/PerfMapListener.hpp"
+
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Process.h>
+
+namespace optiz::jit {
+
+    PerfMapListener::PerfMapListener() {
+        std::string path = "/tmp/perf-" + std::to_string(llvm::sys::Process::getProcessId()) + ".map";
+        std::error_code error;
+
+        m_Out = std::make_unique<llvm::raw_fd_ostream>(path, error, llvm::sys::fs::OF_Append);
+        if (error) {
+            llvm::errs() << "optiz: cannot open '" << path << "': " << error.message() << "\n";
+            m_Out.reset();
+        }
+    }
+
+    void PerfMapListener::notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object,
+                                             const llvm::RuntimeDyld::LoadedObjectInfo& info) {
+        if (!m_Out) {
+            return;
+        }
+
+        // the debug copy of the object has its sections moved to their load addresses
+        llvm::object::OwningBinary<llvm::object::ObjectFile> debugObject = info.getObjectForDebug(object);
+        const llvm::object::ObjectFile& loadedObject = debugObject.getBinary() ? *debugObject.getBinary() : object;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (const auto& [symbol, size] : llvm::object::computeSymbolSizes(loadedObject)) {
+            auto type    = symbol.getType();
+            auto name    = symbol.getName();
+            auto address = symbol.getAddress();
+
+            if (!type || !name || !address) {
+                llvm::consumeError(type.takeError());
+                llvm::consumeError(name.takeError());
+                llvm::consumeError(address.takeError());
+                continue;
+            }
+
+            if (*type == llvm::object::SymbolRef::ST_Function && size != 0) {
+                *m_Out << llvm::format("%llx %llx ", static_cast<unsigned long long>(*address), static_cast<unsigned long long>(size)) << *name << "\n";
+            }
+        }
+
+        // flushed right away so the map is complete even if the program crashes
+        m_Out->flush();
+    }
+
+}  // namespace optiz::jit
@@ -1,36 +1,1039 @@
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/InitLLVM.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <sys/resource.h>
+
+#include <chrono>
 #include <iostream>
 
-#include "fe/Lexer.hpp"
-// #include "fe/AST.hpp"
-// #include "fe/ASTPrinter.hpp"
+#include "cg/Backend.hpp"
+#include "cg/CodeGen.hpp"
+#include "cg/CompilationCache.hpp"
+#include "cg/Profile.hpp"
+#include "cg/Remarks.hpp"
+#include "cg/ScopeTimers.hpp"
+#include "cg/TargetClones.hpp"
+#include "fe/AST.hpp"
+#include "fe/ASTHasher.hpp"
+#include "fe/ASTPrinter.hpp"
+#include "fe/ConstantFolder.hpp"
 #include "fe/Diagnostic.hpp"
-// #include "fe/Parser.hpp"
+#include "fe/IncrementalParser.hpp"
+#include "fe/Lexer.hpp"
+#include "fe/Parser.hpp"
+#include "fe/Statistics.hpp"
+#include "jit/Benchmark.hpp"
+#include "jit/JIT.hpp"
+#include "server/Server.hpp"
+#include "vm/BytecodeCompiler.hpp"
+#include "vm/Interpreter.hpp"
+
+#define TIMER_GROUP             "optiz"
+#define TIMER_GROUP_DESCRIPTION "Compiler phases"
+#define MAX_PARSE_SESSIONS      64
 
 using namespace optiz::fe;
 
-int main() {
-    DiagnosticEngine TheDiagnosticEngine;
-    Lexer lexer("'1'", "main.optiz", TheDiagnosticEngine);
-    // Parser parser("* 1 + 2 * 3 * 4;", "main.optiz", TheDiagnosticEngine);
-    // std::unique_ptr<GenericASTNode> ast = parser.ParseProgram();
+enum class Action {
+    DumpTokens,
+    DumpAST,
+    DumpBytecode,
+    EmitLLVM,
+    EmitObject,
+    Run,
+    Interpret,
+    Bench
+};
+
+static llvm::cl::opt<std::string> s_InputFile(llvm::cl::Positional, llvm::cl::desc("<input file>"), llvm::cl::init("-"));
+
+static llvm::cl::opt<Action> s_Action(
+    llvm::cl::desc("Action to perform:"),
+    llvm::cl::init(Action::EmitLLVM),
+    llvm::cl::values(
+        clEnumValN(Action::DumpTokens, "dump-tokens", "Print the token stream"),
+        clEnumValN(Action::DumpAST, "dump-ast", "Print the AST"),
+        clEnumValN(Action::DumpBytecode, "dump-bytecode", "Print the interpreter bytecode"),
+        clEnumValN(Action::EmitLLVM, "emit-llvm", "Print the generated LLVM IR"),
+        clEnumValN(Action::EmitObject, "c", "Compile to a native object file"),
+        clEnumValN(Action::Run, "run", "JIT-compile and run the program"),
+        clEnumValN(Action::Interpret, "interpret", "Run the program in the bytecode interpreter, promoting hot units to the JIT"),
+        clEnumValN(Action::Bench, "bench", "JIT-compile the units and benchmark them one by one")));
+
+static llvm::cl::opt<std::string> s_OutputFile("o", llvm::cl::desc("Output file"), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<char> s_OptimizationLevel("O", llvm::cl::desc("Optimization level [-O0, -O1, -O2, -O3]"), llvm::cl::Prefix,
+                                               llvm::cl::init('0'));
+
+static llvm::cl::opt<std::string> s_CPU("mcpu", llvm::cl::desc("Target CPU, or 'native' for the host CPU and its features"),
+                                        llvm::cl::value_desc("cpu-name"), llvm::cl::init("generic"));
+
+static llvm::cl::opt<std::string> s_Features("mattr", llvm::cl::desc("Target features, e.g. +avx2,-avx512f"),
+                                             llvm::cl::value_desc("a1,+a2,-a3,..."));
+
+static llvm::cl::opt<llvm::Reloc::Model> s_RelocationModel(
+    "relocation-model", llvm::cl::desc("Relocation model"), llvm::cl::init(llvm::Reloc::PIC_),
+    llvm::cl::values(
+        clEnumValN(llvm::Reloc::Static, "static", "Non-relocatable code"),
+        clEnumValN(llvm::Reloc::PIC_, "pic", "Position independent code"),
+        clEnumValN(llvm::Reloc::DynamicNoPIC, "dynamic-no-pic", "Relocatable external references, non-relocatable code")));
+
+static llvm::cl::opt<llvm::CodeModel::Model> s_CodeModel(
+    "code-model", llvm::cl::desc("Code model (default: target specific)"),
+    llvm::cl::values(
+        clEnumValN(llvm::CodeModel::Tiny, "tiny", "Tiny code model"),
+        clEnumValN(llvm::CodeModel::Small, "small", "Small code model"),
+        clEnumValN(llvm::CodeModel::Kernel, "kernel", "Kernel code model"),
+        clEnumValN(llvm::CodeModel::Medium, "medium", "Medium code model"),
+        clEnumValN(llvm::CodeModel::Large, "large", "Large code model")));
+
+enum class LTOMode {
+    None,
+    Thin
+};
+
+static llvm::cl::list<std::string> s_TargetClones(
+    "target-clones", llvm::cl::desc("With -c, compile every unit once per x86 feature and select one at load time, e.g. avx2,avx512f,default"),
+    llvm::cl::value_desc("feature,..."), llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<LTOMode> s_LTO("flto", llvm::cl::desc("Emit LLVM bitcode for link-time optimization with -c"),
+                                    llvm::cl::init(LTOMode::None),
+                                    llvm::cl::values(clEnumValN(LTOMode::Thin, "thin", "ThinLTO bitcode with a module summary")));
+
+static llvm::cl::opt<unsigned> s_Jobs("j", llvm::cl::desc("Split code generation for -c across N threads"), llvm::cl::value_desc("N"),
+                                      llvm::cl::Prefix, llvm::cl::init(1));
+
+static llvm::cl::opt<std::string> s_CacheDirectory("cache-dir", llvm::cl::desc("Cache compiled units for -c in this directory"),
+                                                   llvm::cl::value_desc("directory"));
+
+static llvm::cl::opt<std::string> s_CachePolicy("cache-policy", llvm::cl::desc("Cache pruning policy, e.g. cache_size_bytes=1g:prune_after=24h"),
+                                                llvm::cl::init(""));
+
+static llvm::cl::opt<bool> s_CacheStats("cache-stats", llvm::cl::desc("Report compilation cache hits and misses"));
+
+static llvm::cl::opt<std::string> s_ServeSocket("serve", llvm::cl::desc("Run as a compile server on this Unix socket (see optiz-client)"),
+                                                llvm::cl::value_desc("socket"));
+
+static llvm::cl::opt<bool> s_JITTimings("jit-timings",
+                                        llvm::cl::desc("Report the compile-vs-run time split of --run, or the calls --interpret ran natively"));
+
+static llvm::cl::opt<unsigned> s_JITThreshold("jit-threshold", llvm::cl::desc("Calls after which --interpret promotes a unit to the JIT (0 = never)"),
+                                              llvm::cl::init(1000));
+
+// A testing aid: a program runs each unit once, so without repeated runs no
+// unit ever reaches --jit-threshold and promotion cannot be exercised.
+static llvm::cl::opt<unsigned> s_InterpretRuns("interpret-runs",
+                                               llvm::cl::desc("Testing aid: run the program this many times with --interpret, so that "
+                                                              "hot units get promoted"),
+                                               llvm::cl::value_desc("N"), llvm::cl::init(1), llvm::cl::Hidden);
+
+static llvm::cl::opt<bool> s_DebugInfo("g", llvm::cl::desc("Emit DWARF line tables and function descriptions"));
+
+static llvm::cl::opt<bool> s_PerfSupport("perf", llvm::cl::desc("Publish JIT-compiled functions to perf in /tmp/perf-<pid>.map and a jitdump"));
+
+static llvm::cl::list<std::string> s_BenchUnits("fn", llvm::cl::desc("Units to --bench, by name or statement index (default: all)"),
+                                                llvm::cl::value_desc("unit,..."), llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<unsigned> s_BenchSamples("bench-samples", llvm::cl::desc("Timed samples per --bench unit, at least 2"), llvm::cl::init(20));
+
+static llvm::cl::opt<bool> s_BenchJSON("bench-json", llvm::cl::desc("Print the --bench results as JSON"));
+
+static llvm::cl::opt<bool> s_FoldConstants("fold-constants", llvm::cl::desc("Fold constant expressions in the AST before code generation"),
+                                           llvm::cl::init(true));
+
+static llvm::cl::opt<bool> s_FoldReport("fold-report", llvm::cl::desc("Report what constant folding did, also in builds without --stats"));
+
+static llvm::cl::opt<bool> s_Instrument("instrument", llvm::cl::desc("Count how often every unit runs and write the counts to the profile file at exit"));
+
+static llvm::cl::opt<std::string> s_ProfileOutput("profile-output", llvm::cl::desc("Profile file written by an --instrument build"),
+                                                  llvm::cl::value_desc("filename"), llvm::cl::init("optiz.profile"));
+
+static llvm::cl::opt<std::string> s_UseProfile("use-profile", llvm::cl::desc("Optimize with the counts recorded by an --instrument build"),
+                                               llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<bool> s_InstrumentScopes("instrument-scopes",
+                                              llvm::cl::desc("Time every unit with the cycle counter and report the totals at exit"));
+
+static llvm::cl::opt<std::string> s_ScopeReport("scope-report", llvm::cl::desc("Also write the --instrument-scopes report as JSON"),
+                                                llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> s_RemarksPassed("Rpass", llvm::cl::desc("Report the optimizations done by passes matching the regex"),
+                                                  llvm::cl::value_desc("regex"));
+
+static llvm::cl::opt<std::string> s_RemarksMissed("Rpass-missed", llvm::cl::desc("Report the optimizations that passes matching the regex failed to do"),
+                                                  llvm::cl::value_desc("regex"));
+
+static llvm::cl::opt<std::string> s_RemarksAnalysis("Rpass-analysis",
+                                                    llvm::cl::desc("Report the analyses of passes matching the regex that explain their decisions"),
+                                                    llvm::cl::value_desc("regex"));
+
+static llvm::cl::opt<std::string> s_RemarksFile("remarks-file", llvm::cl::desc("Write the optimization remarks to this file"),
+                                                 llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string> s_RemarksFilter("remarks-filter", llvm::cl::desc("Only write the remarks of passes matching the regex"),
+                                                  llvm::cl::value_desc("regex"));
+
+static llvm::cl::opt<std::string> s_RemarksFormat("remarks-format", llvm::cl::desc("Format of --remarks-file (yaml or bitstream)"),
+                                                  llvm::cl::init("yaml"));
+
+static llvm::cl::opt<bool> s_TimeTrace("ftime-trace", llvm::cl::desc("Write a Chrome trace of the compilation next to the output (<output>.json)"));
 
-    // ASTPrinter printer;
-    // ast->accept(printer);
+static llvm::cl::opt<unsigned> s_TimeTraceGranularity("ftime-trace-granularity",
+                                                      llvm::cl::desc("Minimum duration of a -ftime-trace event in microseconds"),
+                                                      llvm::cl::init(500));
 
-    Token token;
+static llvm::cl::opt<bool> s_TimeReport("time-report", llvm::cl::desc("Report the time spent in each compiler phase and pass"));
 
-    do {
-        token = lexer.GetNextToken();
-        std::cout << token << std::endl;
-    } while (token != TokenType::EndOfFile);
+static int dumpDiagnostics(DiagnosticEngine& diagnosticEngine) {
+    if (diagnosticEngine.HasReports()) {
+        diagnosticEngine.Dump();
+        diagnosticEngine.Clear();
+    }
+
+    return diagnosticEngine.HasErrors() ? 1 : 0;
+}
+
+static double toMilliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static llvm::OptimizationLevel getOptimizationLevel() {
+    switch (s_OptimizationLevel) {
+        case '0': return llvm::OptimizationLevel::O0;
+        case '1': return llvm::OptimizationLevel::O1;
+        case '2': return llvm::OptimizationLevel::O2;
+        case '3': return llvm::OptimizationLevel::O3;
+        default:
+            llvm::errs() << "optiz: invalid optimization level -O" << s_OptimizationLevel << "\n";
+            exit(1);
+    }
+}
+
+static optiz::cg::BackendOptions getBackendOptions() {
+    optiz::cg::BackendOptions options;
+    options.m_CPU               = s_CPU;
+    options.m_Features          = s_Features;
+    options.m_RelocationModel   = s_RelocationModel.getValue();
+    options.m_OptimizationLevel = getOptimizationLevel();
+
+    if (s_CodeModel.getNumOccurrences() > 0) {
+        options.m_CodeModel = s_CodeModel.getValue();
+    }
+
+    return options;
+}
+
+static llvm::json::Value toJSON(const optiz::cg::BackendOptions& options) {
+    auto toJSON = [](const auto& optional) { return optional ? llvm::json::Value(static_cast<int64_t>(*optional)) : nullptr; };
+
+    return llvm::json::Object{
+        { "cpu", options.m_CPU },
+        { "features", options.m_Features },
+        { "relocation_model", toJSON(options.m_RelocationModel) },
+        { "code_model", toJSON(options.m_CodeModel) },
+        { "optimization_level", static_cast<int64_t>(options.m_OptimizationLevel.getSpeedupLevel()) },
+    };
+}
+
+static llvm::Optional<optiz::cg::BackendOptions> backendOptionsFromJSON(const llvm::json::Object& object) {
+    optiz::cg::BackendOptions options;
+
+    llvm::Optional<llvm::StringRef> cpu      = object.getString("cpu");
+    llvm::Optional<llvm::StringRef> features = object.getString("features");
+    llvm::Optional<int64_t> level            = object.getInteger("optimization_level");
+    if (!cpu || !features || !level) {
+        return llvm::None;
+    }
+
+    options.m_CPU      = cpu->str();
+    options.m_Features = features->str();
+
+    if (llvm::Optional<int64_t> model = object.getInteger("relocation_model")) {
+        options.m_RelocationModel = static_cast<llvm::Reloc::Model>(*model);
+    }
+    if (llvm::Optional<int64_t> model = object.getInteger("code_model")) {
+        options.m_CodeModel = static_cast<llvm::CodeModel::Model>(*model);
+    }
+
+    switch (*level) {
+        case 0: options.m_OptimizationLevel = llvm::OptimizationLevel::O0; break;
+        case 1: options.m_OptimizationLevel = llvm::OptimizationLevel::O1; break;
+        case 2: options.m_OptimizationLevel = llvm::OptimizationLevel::O2; break;
+        case 3: options.m_OptimizationLevel = llvm::OptimizationLevel::O3; break;
+        default: return llvm::None;
+    }
+
+    return options;
+}
+
+// One per set of options. A compile server creates them between requests, so
+// its requests find them ready.
+static llvm::StringMap<std::unique_ptr<llvm::TargetMachine>> s_TargetMachines;
+
+static llvm::Expected<llvm::TargetMachine*> getTargetMachine(const optiz::cg::BackendOptions& options) {
+    std::unique_ptr<llvm::TargetMachine>& targetMachine = s_TargetMachines[llvm::formatv("{0}", toJSON(options)).str()];
+
+    if (!targetMachine) {
+        auto created = optiz::cg::CreateTargetMachine(options);
+        if (!created) {
+            return created.takeError();
+        }
+        targetMachine = std::move(*created);
+    }
+
+    return targetMachine.get();
+}
+
+// One per input file, by absolute path. A compile server keeps them up to
+// date between requests, so a request only re-parses what changed since.
+static llvm::StringMap<std::unique_ptr<IncrementalParser>> s_ParseSessions;
+
+static std::string getAbsoluteInputPath() {
+    llvm::SmallString<256> path(s_InputFile.getValue());
+    llvm::sys::fs::make_absolute(path);
+    return path.str().str();
+}
+
+// The program of a session brought up to date with `input`, or null without a
+// session or when the text has errors, which a full parse reports.
+static std::unique_ptr<GenericASTNode> parseIncrementally(const std::string& input, const std::string& fileName) {
+    if (s_InputFile == "-") {
+        return nullptr;
+    }
 
-    if (TheDiagnosticEngine.HasReports()) {
-        TheDiagnosticEngine.Dump();
+    auto session = s_ParseSessions.find(getAbsoluteInputPath());
+    if (session == s_ParseSessions.end() || session->second->GetFile() != fileName) {
+        return nullptr;
+    }
+
+    session->second->ReplaceText(input);
+    if (session->second->HasDiagnostics()) {
+        return nullptr;
+    }
+
+    return session->second->BuildProgram();
+}
 
-        if (TheDiagnosticEngine.HasErrors()) {
+static bool remarksRequested() {
+    return !s_RemarksPassed.empty() || !s_RemarksMissed.empty() || !s_RemarksAnalysis.empty() || !s_RemarksFile.empty();
+}
+
+// Remarks are located through the debug info, so they turn it on.
+static bool emitDebugInfo() {
+    return s_DebugInfo || remarksRequested();
+}
+
+static std::string getObjectFileName() {
+    if (!s_OutputFile.empty()) {
+        return s_OutputFile;
+    }
+
+    if (s_InputFile == "-") {
+        return "a.o";
+    }
+
+    llvm::SmallString<128> path(llvm::sys::path::filename(s_InputFile));
+    llvm::sys::path::replace_extension(path, "o");
+    return path.str().str();
+}
+
+static std::string getTraceFileName() {
+    llvm::SmallString<128> path(getObjectFileName());
+    llvm::sys::path::replace_extension(path, "json");
+    return path.str().str();
+}
+
+// Free unless --time-report is given.
+static llvm::NamedRegionTimer timePhase(llvm::StringRef name, llvm::StringRef description) {
+    return llvm::NamedRegionTimer(name, description, TIMER_GROUP, TIMER_GROUP_DESCRIPTION, s_TimeReport);
+}
+
+// Length-prefixed, so neighbouring fields cannot run into each other.
+static void hashField(llvm::SHA1& hasher, llvm::StringRef field) {
+    uint8_t size[sizeof(uint32_t)];
+    llvm::support::endian::write32le(size, field.size());
+
+    hasher.update(llvm::ArrayRef<uint8_t>(size));
+    hasher.update(field);
+}
+
+// Keyed by the unit's code and the options, not by its position, so inserting
+// a statement leaves the units after it cached. Only the debug info records
+// the unit's name and file.
+static std::string getUnitCacheKey(const GenericASTNode& unit, llvm::StringRef unitName, llvm::StringRef sourceFileName,
+                                   const llvm::TargetMachine& targetMachine, const optiz::cg::BackendOptions& options) {
+    llvm::SHA1 hasher;
+
+    hashField(hasher, "optiz " OPTIZ_VERSION " llvm " LLVM_VERSION_STRING);
+    hashField(hasher, targetMachine.getTargetTriple().str());
+    hashField(hasher, targetMachine.getTargetCPU());
+    hashField(hasher, targetMachine.getTargetFeatureString());
+    hashField(hasher, std::to_string(options.m_OptimizationLevel.getSpeedupLevel()));
+    hashField(hasher, std::to_string(targetMachine.getRelocationModel()));
+    hashField(hasher, std::to_string(targetMachine.getCodeModel()));
+    hashField(hasher, emitDebugInfo() ? "debug" : "nodebug");
+    hashField(hasher, std::to_string(s_TargetClones.size()));
+
+    for (const std::string& target : s_TargetClones) {
+        hashField(hasher, target);
+    }
+
+    if (emitDebugInfo()) {
+        // the debug info names the file with its absolute directory
+        llvm::SmallString<128> path(sourceFileName);
+        llvm::sys::fs::make_absolute(path);
+        hashField(hasher, path);
+        hashField(hasher, unitName);
+    }
+
+    ASTHasher astHasher(hasher, emitDebugInfo() ? HashedLocations::All : HashedLocations::Divisions);
+    unit.accept(astHasher);
+
+    return llvm::toHex(hasher.final(), true);
+}
+
+static std::string getProfileHash(const GenericASTNode& node) {
+    llvm::SHA1 hasher;
+    ASTHasher astHasher(hasher);
+    node.accept(astHasher);
+
+    return llvm::toHex(hasher.final(), true).substr(0, 16);
+}
+
+// `main` is keyed by the whole program, so it goes stale with any edit.
+static std::vector<optiz::cg::ProfileUnit> getProfileUnits(const ProgramAST& program) {
+    std::vector<optiz::cg::ProfileUnit> units = { { "main", getProfileHash(program) } };
+
+    for (size_t i = 0; i < program.GetExpressions().size(); i++) {
+        units.push_back({ optiz::cg::CodeGen::GetUnitName(i), getProfileHash(*program.GetExpressions()[i]) });
+    }
+
+    return units;
+}
+
+static llvm::Error setUpProfiling(const ProgramAST& program, llvm::Module& module) {
+    if (s_Instrument) {
+        optiz::cg::InstrumentModule(module, getProfileUnits(program), s_ProfileOutput);
+    }
+
+    if (!s_UseProfile.empty()) {
+        auto profile = optiz::cg::ReadProfile(s_UseProfile);
+        if (!profile) {
+            return profile.takeError();
+        }
+
+        for (const std::string& unit : optiz::cg::ApplyProfile(module, getProfileUnits(program), *profile)) {
+            llvm::errs() << "optiz: warning: '" << s_UseProfile << "' has no up-to-date profile for " << unit << "\n";
+        }
+    }
+
+    return llvm::Error::success();
+}
+
+static std::vector<optiz::cg::InstrumentedScope> getInstrumentedScopes(const ProgramAST& program) {
+    std::vector<optiz::cg::InstrumentedScope> scopes;
+
+    for (size_t i = 0; i < program.GetExpressions().size(); i++) {
+        scopes.push_back({ optiz::cg::CodeGen::GetUnitName(i), program.GetExpressions()[i]->GetStartLocation() });
+    }
+
+    return scopes;
+}
+
+static llvm::Error createTargetClones(llvm::Function& function, const llvm::TargetMachine& targetMachine) {
+    std::vector<std::string> targets(s_TargetClones.begin(), s_TargetClones.end());
+    return optiz::cg::CreateTargetClones(function, targetMachine, targets);
+}
+
+// Compiles every unit into its own object through the cache, so only units whose
+// hash changed are optimized and emitted again. `main` is always recompiled.
+// Each object defines its unit under a name derived from the cache key, which
+// main's calls are redirected to; identical units share one object.
+static int emitObjectCached(const ProgramAST& program, llvm::Module& module, llvm::TargetMachine& targetMachine,
+                            const optiz::cg::BackendOptions& options) {
+    llvm::ExitOnError exitOnError("optiz: ");
+
+    auto cache = exitOnError(optiz::cg::CompilationCache::Create(s_CacheDirectory));
+    std::vector<llvm::SmallString<0>> objects;
+
+    for (size_t i = 0; i < program.GetExpressions().size(); i++) {
+        const GenericASTNode& unit = *program.GetExpressions()[i];
+        std::string unitName       = optiz::cg::CodeGen::GetUnitName(i);
+        std::string key            = getUnitCacheKey(unit, unitName, module.getSourceFileName(), targetMachine, options);
+        std::string symbol         = "optiz.cached." + key;
+
+        // main only keeps a declaration of the unit, its code comes from the cached object
+        llvm::Function* declaration = module.getFunction(unitName);
+        declaration->deleteBody();
+
+        if (llvm::Function* shared = module.getFunction(symbol)) {
+            declaration->replaceAllUsesWith(shared);
+            declaration->eraseFromParent();
+            continue;
+        }
+
+        declaration->setName(symbol);
+        declaration->setLinkage(llvm::Function::ExternalLinkage);
+        declaration->setVisibility(llvm::Function::HiddenVisibility);
+
+        objects.push_back(exitOnError(cache->GetOrCompile(key, [&](llvm::raw_pwrite_stream& out) {
+            llvm::Module unitModule(unitName, module.getContext());
+            unitModule.setTargetTriple(module.getTargetTriple());
+            unitModule.setDataLayout(module.getDataLayout());
+            unitModule.setSourceFileName(module.getSourceFileName());
+
+            optiz::cg::CodeGen codeGen(unitModule, emitDebugInfo());
+            llvm::Function* function = codeGen.GenerateUnit(unit, i);
+            codeGen.FinalizeDebugInfo();
+            function->setName(symbol);
+            function->setLinkage(llvm::Function::ExternalLinkage);
+            function->setVisibility(llvm::Function::HiddenVisibility);
+
+            if (!s_TargetClones.empty()) {
+                if (llvm::Error error = createTargetClones(*function, targetMachine)) {
+                    return error;
+                }
+            }
+
+            optiz::cg::OptimizeModule(unitModule, targetMachine, options.m_OptimizationLevel);
+            return optiz::cg::EmitObjectFile(unitModule, targetMachine, out);
+        })));
+    }
+
+    optiz::cg::OptimizeModule(module, targetMachine, options.m_OptimizationLevel);
+
+    llvm::SmallString<0> mainObject;
+    llvm::raw_svector_ostream out(mainObject);
+    exitOnError(optiz::cg::EmitObjectFile(module, targetMachine, out));
+    objects.push_back(std::move(mainObject));
+
+    exitOnError(optiz::cg::LinkObjectFiles(objects, getObjectFileName()));
+
+    if (!s_CachePolicy.empty()) {
+        exitOnError(cache->Prune(s_CachePolicy));
+    }
+
+    if (s_CacheStats) {
+        const optiz::cg::CacheStats& stats = cache->GetStats();
+        llvm::errs() << "cache: " << stats.m_Hits << " hits, " << stats.m_Misses << " misses\n";
+    }
+
+    return 0;
+}
+
+static int emitObject(const ProgramAST& program, llvm::Module& module) {
+    llvm::ExitOnError exitOnError("optiz: ");
+
+    optiz::cg::BackendOptions options  = getBackendOptions();
+    llvm::TargetMachine* targetMachine = exitOnError(getTargetMachine(options));
+
+    module.setTargetTriple(targetMachine->getTargetTriple().str());
+    module.setDataLayout(targetMachine->createDataLayout());
+
+    // the cache holds objects, ThinLTO emits bitcode
+    if (s_LTO == LTOMode::Thin && !s_CacheDirectory.empty()) {
+        llvm::errs() << "optiz: --cache-dir cannot be combined with -flto=thin\n";
+        return 1;
+    }
+
+    // a ThinLTO build emits a single bitcode file
+    if (s_LTO == LTOMode::Thin && s_Jobs > 1) {
+        llvm::errs() << "optiz: -j cannot be combined with -flto=thin\n";
+        return 1;
+    }
+
+    if (!s_CacheDirectory.empty()) {
+        // cached units are compiled without the instrumentation or the profile
+        if (s_Instrument || !s_UseProfile.empty() || s_InstrumentScopes) {
+            llvm::errs() << "optiz: --instrument, --instrument-scopes and --use-profile cannot be combined with --cache-dir\n";
             return 1;
         }
+
+        return emitObjectCached(program, module, *targetMachine, options);
+    }
+
+    // the partitions are compiled in contexts of their own, without the remark handler
+    if (remarksRequested() && s_Jobs > 1) {
+        llvm::errs() << "optiz: optimization remarks cannot be combined with -j\n";
+        return 1;
     }
 
+    if (!s_TargetClones.empty()) {
+        // llvm::SplitModule does not carry ifuncs over into the partitions
+        if (s_Jobs > 1) {
+            llvm::errs() << "optiz: --target-clones cannot be combined with -j\n";
+            return 1;
+        }
+
+        for (size_t i = 0; i < program.GetExpressions().size(); i++) {
+            exitOnError(createTargetClones(*module.getFunction(optiz::cg::CodeGen::GetUnitName(i)), *targetMachine));
+        }
+    }
+
+    if (s_Jobs > 1) {
+        auto objects = exitOnError(optiz::cg::EmitObjectFilesParallel(module, options, s_Jobs));
+        exitOnError(optiz::cg::LinkObjectFiles(objects, getObjectFileName()));
+        return 0;
+    }
+
+    optiz::cg::OptimizeModule(module, *targetMachine, options.m_OptimizationLevel, s_LTO == LTOMode::Thin);
+
+    std::error_code error;
+    llvm::ToolOutputFile output(getObjectFileName(), error, llvm::sys::fs::OF_None);
+    if (error) {
+        llvm::errs() << "optiz: cannot open '" << getObjectFileName() << "': " << error.message() << "\n";
+        return 1;
+    }
+
+    if (s_LTO == LTOMode::Thin) {
+        optiz::cg::EmitThinLTOBitcode(module, *targetMachine, output.os());
+    } else {
+        exitOnError(optiz::cg::EmitObjectFile(module, *targetMachine, output.os()));
+    }
+    output.keep();
+
     return 0;
 }
+
+static int runJIT(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context,
+                  std::chrono::nanoseconds frontendTime) {
+    llvm::ExitOnError exitOnError("optiz: ");
+
+    auto jit = exitOnError(optiz::jit::JIT::Create(s_PerfSupport));
+    exitOnError(jit->AddLazyModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))));
+
+    auto start   = std::chrono::steady_clock::now();
+    int exitCode = exitOnError(jit->RunMain());
+    auto end     = std::chrono::steady_clock::now();
+
+    fflush(stdout);
+
+    if (s_JITTimings) {
+        std::chrono::nanoseconds compileTime = jit->GetCompileTime();
+        std::chrono::nanoseconds runTime     = end - start - compileTime;
+
+        llvm::errs() << llvm::format("frontend: %.3f ms, jit compile: %.3f ms (%llu functions), run: %.3f ms\n",
+                                     toMilliseconds(frontendTime), toMilliseconds(compileTime),
+                                     jit->GetCompiledFunctionCount(), toMilliseconds(runTime));
+    }
+
+    return exitCode;
+}
+
+static llvm::Expected<std::vector<std::string>> getBenchmarkedUnits(const ProgramAST& program) {
+    std::vector<std::string> units;
+    size_t unitCount = program.GetExpressions().size();
+
+    if (s_BenchUnits.empty()) {
+        for (size_t i = 0; i < unitCount; i++) {
+            units.push_back(optiz::cg::CodeGen::GetUnitName(i));
+        }
+
+        return units;
+    }
+
+    for (const std::string& unit : s_BenchUnits) {
+        llvm::StringRef indexString = unit;
+        indexString.consume_front("optiz.stmt.");  // by name or by index
+
+        size_t index;
+        if (indexString.getAsInteger(10, index) || index >= unitCount) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "no unit '" + unit + "' to benchmark");
+        }
+
+        units.push_back(optiz::cg::CodeGen::GetUnitName(index));
+    }
+
+    return units;
+}
+
+// Optimized like -c, but units stay callable on their own instead of being
+// inlined into main and dropped.
+static int runBenchmarks(const ProgramAST& program, std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context) {
+    llvm::ExitOnError exitOnError("optiz: ");
+
+    // a standard deviation needs two samples
+    if (s_BenchSamples < 2) {
+        llvm::errs() << "optiz: --bench-samples must be at least 2\n";
+        return 1;
+    }
+
+    std::vector<std::string> units = exitOnError(getBenchmarkedUnits(program));
+
+    optiz::cg::BackendOptions options  = getBackendOptions();
+    llvm::TargetMachine* targetMachine = exitOnError(getTargetMachine(options));
+
+    module->setTargetTriple(targetMachine->getTargetTriple().str());
+    module->setDataLayout(targetMachine->createDataLayout());
+
+    for (const std::string& unit : units) {
+        module->getFunction(unit)->setLinkage(llvm::Function::ExternalLinkage);
+    }
+
+    optiz::cg::OptimizeModule(*module, *targetMachine, options.m_OptimizationLevel);
+
+    auto jit = exitOnError(optiz::jit::JIT::Create(s_PerfSupport));
+    exitOnError(jit->AddModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))));
+
+    optiz::jit::BenchmarkOptions benchmarkOptions;
+    benchmarkOptions.m_Samples = s_BenchSamples;
+
+    std::vector<optiz::jit::BenchmarkResult> results;
+    for (const std::string& unit : units) {
+        auto* function = reinterpret_cast<optiz::jit::UnitFunction>(exitOnError(jit->Lookup(unit)));
+        results.push_back(optiz::jit::RunBenchmark(unit, function, benchmarkOptions));
+    }
+
+    if (s_BenchJSON) {
+        optiz::jit::PrintBenchmarkResultsJSON(results, llvm::outs());
+    } else {
+        optiz::jit::PrintBenchmarkResults(results, llvm::outs());
+    }
+
+    return 0;
+}
+
+static llvm::Expected<std::unique_ptr<llvm::ToolOutputFile>> setUpRemarks(llvm::LLVMContext& context, const std::string& fileName,
+                                                                          DiagnosticEngine& diagnosticEngine) {
+    optiz::cg::RemarkFilters filters = { s_RemarksPassed, s_RemarksMissed, s_RemarksAnalysis };
+
+    for (const std::string& pattern : { filters.m_Passed, filters.m_Missed, filters.m_Analysis }) {
+        std::string error;
+        if (!pattern.empty() && !llvm::Regex(pattern).isValid(error)) {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(), "invalid remark filter '" + pattern + "': " + error);
+        }
+    }
+
+    context.setDiagnosticHandler(std::make_unique<optiz::cg::RemarkHandler>(diagnosticEngine, fileName, filters));
+
+    // null without a remarks file
+    return llvm::setupLLVMOptimizationRemarks(context, s_RemarksFile, s_RemarksFilter, s_RemarksFormat, false);
+}
+
+static int runInterpreter(const ProgramAST& program) {
+    optiz::vm::BytecodeCompiler compiler;
+    program.accept(compiler);
+    optiz::vm::BytecodeModule module = compiler.TakeModule();
+
+    if (s_Action == Action::DumpBytecode) {
+        std::cout << module;
+        return 0;
+    }
+
+    std::unique_ptr<optiz::vm::JITPromoter> promoter;
+    if (s_JITThreshold != 0) {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        promoter = std::make_unique<optiz::vm::JITPromoter>(program, getBackendOptions());
+    }
+
+    optiz::vm::Interpreter interpreter(module, std::move(promoter), s_JITThreshold);
+    llvm::Error error = interpreter.RunMain(s_InterpretRuns);
+
+    // a failed division is reported like the check in the generated code
+    fflush(stdout);
+    if (error) {
+        llvm::errs() << llvm::toString(std::move(error)) << "\n";
+        return 1;
+    }
+
+    if (s_JITTimings) {
+        llvm::errs() << "interpreted: " << interpreter.GetInterpretedCallCount() << " calls, native: " << interpreter.GetNativeCallCount()
+                     << " calls\n";
+    }
+
+    return 0;
+}
+
+static int compileInput() {
+    // the clones are selected by an ifunc resolver when an object file is loaded
+    if (!s_TargetClones.empty() && s_Action != Action::EmitObject) {
+        llvm::errs() << "optiz: --target-clones can only be used with -c\n";
+        return 1;
+    }
+
+    auto buffer = llvm::MemoryBuffer::getFileOrSTDIN(s_InputFile);
+    if (!buffer) {
+        llvm::errs() << "optiz: cannot read '" << s_InputFile << "': " << buffer.getError().message() << "\n";
+        return 1;
+    }
+
+    std::string input    = (*buffer)->getBuffer().str();
+    std::string fileName = s_InputFile == "-" ? "<stdin>" : s_InputFile.getValue();
+
+    DiagnosticEngine TheDiagnosticEngine;
+
+    if (s_Action == Action::DumpTokens) {
+        auto timer = timePhase("lex", "Lexing");
+        Lexer lexer(input, fileName, TheDiagnosticEngine);
+        Token token;
+
+        do {
+            token = lexer.GetNextToken();
+            std::cout << token << std::endl;
+        } while (token != TokenType::EndOfFile);
+
+        return dumpDiagnostics(TheDiagnosticEngine);
+    }
+
+    auto frontendStart = std::chrono::steady_clock::now();
+
+    std::unique_ptr<GenericASTNode> ast;
+    {
+        auto timer = timePhase("parse", "Lexing and parsing");
+        ast        = parseIncrementally(input, fileName);
+
+        if (!ast) {
+            Parser parser(input, fileName, TheDiagnosticEngine);
+            ast = parser.ParseProgram();
+        }
+    }
+
+    if (dumpDiagnostics(TheDiagnosticEngine) != 0) {
+        return 1;
+    }
+
+    if (s_Action == Action::DumpAST) {
+        ASTPrinter printer;
+        ast->accept(printer);
+        return 0;
+    }
+
+    if (s_FoldConstants) {
+        auto timer = timePhase("fold", "Constant folding");
+        llvm::TimeTraceScope scope("FoldConstants");
+
+        ConstantFolder folder;
+        ast = folder.Fold(std::move(ast));
+
+        OPTIZ_STAT(GetFrontendStatistics().m_FoldedNodes += folder.GetFoldedNodeCount());
+        OPTIZ_STAT(GetFrontendStatistics().m_SimplifiedNodes += folder.GetSimplifiedNodeCount());
+
+        if (s_FoldReport) {
+            llvm::errs() << "fold: " << folder.GetFoldedNodeCount() << " nodes folded to constants, " << folder.GetSimplifiedNodeCount()
+                         << " nodes removed by identities\n";
+        }
+    }
+
+    if (s_Action == Action::DumpBytecode || s_Action == Action::Interpret) {
+        auto timer = timePhase("interpret", "Bytecode compilation and interpretation");
+        return runInterpreter(*llvm::cast<ProgramAST>(ast.get()));
+    }
+
+    // outlives the context, whose remark streamer writes to it
+    std::unique_ptr<llvm::ToolOutputFile> remarksFile;
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module  = std::make_unique<llvm::Module>(fileName, *context);
+
+    if (remarksRequested()) {
+        if (s_Action != Action::EmitObject && s_Action != Action::Bench) {
+            llvm::errs() << "optiz: optimization remarks need -c or --bench, the actions that optimize\n";
+            return 1;
+        }
+
+        llvm::ExitOnError exitOnError("optiz: ");
+        remarksFile = exitOnError(setUpRemarks(*context, fileName, TheDiagnosticEngine));
+    }
+
+    {
+        auto timer = timePhase("codegen", "LLVM IR generation");
+        optiz::cg::CodeGen codeGen(*module, emitDebugInfo());
+        ast->accept(codeGen);
+    }
+
+    if (s_Instrument || !s_UseProfile.empty()) {
+        llvm::ExitOnError exitOnError("optiz: ");
+        exitOnError(setUpProfiling(*llvm::cast<ProgramAST>(ast.get()), *module));
+    }
+
+    if (s_InstrumentScopes) {
+        optiz::cg::InstrumentScopes(*module, getInstrumentedScopes(*llvm::cast<ProgramAST>(ast.get())), s_ScopeReport);
+    }
+
+    auto frontendEnd = std::chrono::steady_clock::now();
+
+    if (s_Action == Action::EmitLLVM) {
+        module->print(llvm::outs(), nullptr);
+        return 0;
+    }
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    int exitCode = 0;
+
+    if (s_Action == Action::EmitObject) {
+        auto timer = timePhase("backend", "Optimization and code emission");
+        exitCode   = emitObject(*llvm::cast<ProgramAST>(ast.get()), *module);
+    } else if (s_Action == Action::Bench) {
+        auto timer = timePhase("bench", "Benchmarking");
+        exitCode   = runBenchmarks(*llvm::cast<ProgramAST>(ast.get()), std::move(module), std::move(context));
+    } else {
+        auto timer = timePhase("run", "JIT compilation and execution");
+        exitCode   = runJIT(std::move(module), std::move(context), frontendEnd - frontendStart);
+    }
+
+    // the optimization remarks
+    if (dumpDiagnostics(TheDiagnosticEngine) != 0) {
+        exitCode = 1;
+    }
+
+    if (remarksFile) {
+        remarksFile->keep();
+    }
+
+    return exitCode;
+}
+
+// Reported with LLVM's own --stats flag.
+static void printStatistics() {
+#if OPTIZ_ENABLE_STATS
+    PrintFrontendStatistics(std::cerr);
+#endif
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        std::cerr << "peak RSS: " << usage.ru_maxrss << " KiB\n";
+    }
+}
+
+static int compile() {
+    if (s_TimeTrace) {
+        llvm::timeTraceProfilerInitialize(s_TimeTraceGranularity, "optiz");
+    }
+
+    llvm::TimePassesIsEnabled = s_TimeReport;
+
+    int exitCode = compileInput();
+
+    if (llvm::AreStatisticsEnabled()) {
+        printStatistics();
+    }
+
+    if (s_TimeReport) {
+        llvm::TimerGroup::printAll(llvm::errs());
+        llvm::TimerGroup::clearAll();  // don't print them again at exit
+    }
+
+    if (llvm::timeTraceProfilerEnabled()) {
+        std::string traceFile = getTraceFileName();
+
+        if (llvm::Error error = llvm::timeTraceProfilerWrite(traceFile, traceFile)) {
+            llvm::errs() << "optiz: cannot write '" << traceFile << "': " << llvm::toString(std::move(error)) << "\n";
+            exitCode = 1;
+        }
+
+        llvm::timeTraceProfilerCleanup();
+    }
+
+    return exitCode;
+}
+
+// What a compile server should prepare after this request, see warmUpServer.
+static std::string getWarmUpNote() {
+    llvm::json::Object note;
+
+    if (s_Action == Action::EmitObject || s_Action == Action::Bench) {
+        note["target"] = toJSON(getBackendOptions());
+    }
+    if (s_InputFile != "-" && s_Action != Action::DumpTokens) {
+        note["input"] = llvm::json::Object{ { "path", getAbsoluteInputPath() },
+                                            { "file", s_InputFile.getValue() } };
+    }
+
+    return llvm::formatv("{0}", llvm::json::Value(std::move(note))).str();
+}
+
+static int serveRequest(int argc, const char** argv, std::string& warmUpNote) {
+    llvm::cl::ResetAllOptionOccurrences();
+    if (!llvm::cl::ParseCommandLineOptions(argc, argv, "optiz compiler\n", &llvm::errs())) {
+        return 1;
+    }
+
+    int exitCode = compile();
+    warmUpNote   = getWarmUpNote();
+
+    return exitCode;
+}
+
+// Runs in the compile server between requests. It never sees a request's
+// arguments: parsing them here could exit the server, e.g. on --help.
+static void warmUpServer(llvm::StringRef warmUpNote) {
+    auto note = llvm::json::parse(warmUpNote);
+    if (!note) {
+        llvm::consumeError(note.takeError());
+        return;
+    }
+
+    const llvm::json::Object* object = note->getAsObject();
+    if (!object) {
+        return;
+    }
+
+    if (const llvm::json::Object* target = object->getObject("target")) {
+        if (llvm::Optional<optiz::cg::BackendOptions> options = backendOptionsFromJSON(*target)) {
+            llvm::consumeError(getTargetMachine(*options).takeError());
+        }
+    }
+
+    if (const llvm::json::Object* input = object->getObject("input")) {
+        llvm::Optional<llvm::StringRef> path = input->getString("path");
+        llvm::Optional<llvm::StringRef> file = input->getString("file");
+        if (!path || !file) {
+            return;
+        }
+
+        auto buffer = llvm::MemoryBuffer::getFile(*path);
+        if (!buffer) {
+            s_ParseSessions.erase(*path);
+            return;
+        }
+
+        auto session = s_ParseSessions.find(*path);
+        if (session != s_ParseSessions.end() && session->second->GetFile() == *file) {
+            session->second->ReplaceText((*buffer)->getBuffer().str());
+            return;
+        }
+
+        if (session == s_ParseSessions.end() && s_ParseSessions.size() >= MAX_PARSE_SESSIONS) {
+            s_ParseSessions.clear();
+        }
+        s_ParseSessions[*path] = std::make_unique<IncrementalParser>((*buffer)->getBuffer().str(), file->str());
+    }
+}
+
+int main(int argc, char** argv) {
+    llvm::InitLLVM initLLVM(argc, argv);
+    llvm::cl::ParseCommandLineOptions(argc, argv, "optiz compiler\n");
+
+    if (!s_ServeSocket.empty()) {
+        // initialize once, every request is forked from this process
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+
+        return optiz::server::Serve(s_ServeSocket, serveRequest, warmUpServer);
+    }
+
+    return compile();
+}
@@ -0,0 +1,55 @@
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "server/Protocol.hpp"
+
+// Thin client for `optiz --serve`: forwards its arguments, working directory
+// and standard streams to the server and exits with the compilation's status.
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <socket> [optiz arguments...]\n", argv[0]);
+        return 1;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family  = AF_UNIX;
+
+    if (strlen(argv[1]) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "optiz-client: socket path too long: %s\n", argv[1]);
+        return 1;
+    }
+    strcpy(address.sun_path, argv[1]);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        perror("optiz-client: cannot connect to the server");
+        return 1;
+    }
+
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("optiz-client: cannot get the working directory");
+        return 1;
+    }
+
+    std::vector<std::string> payload = { cwd, "optiz" };
+    for (int i = 2; i < argc; i++) {
+        payload.push_back(argv[i]);
+    }
+
+    int32_t exitCode;
+
+    if (!optiz::server::SendRequest(fd, payload) || !optiz::server::ReadAll(fd, &exitCode, sizeof(exitCode))) {
+        fprintf(stderr, "optiz-client: lost connection to the server\n");
+        return 1;
+    }
+
+    close(fd);
+    return exitCode;
+}
@@ -0,0 +1,162 @@
+#include "server/Protocol.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#define PASSED_FDS 3
+
+// Linux's default ARG_MAX, no command line is longer.
+#define MAX_REQUEST_SIZE (2 << 20)
+
+static bool parsePayload(const std::string& data, std::vector<std::string>& payload);
+static void closeAll(const std::vector<int>& fds);
+
+namespace optiz::server {
+
+    bool SendRequest(int socket, const std::vector<std::string>& payload) {
+        std::string data;
+        for (const std::string& part : payload) {
+            data += part;
+            data += '\0';
+        }
+
+        if (data.size() > MAX_REQUEST_SIZE) {
+            return false;
+        }
+
+        uint32_t size = data.size();
+        int fds[PASSED_FDS] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+
+        char control[CMSG_SPACE(sizeof(fds))] = {};
+        iovec iov = { &size, sizeof(size) };
+
+        msghdr message        = {};
+        message.msg_iov        = &iov;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        cmsghdr* header    = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type  = SCM_RIGHTS;
+        header->cmsg_len   = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+        if (sendmsg(socket, &message, 0) != sizeof(size)) {
+            return false;
+        }
+
+        return WriteAll(socket, data.data(), data.size());
+    }
+
+    bool ReceiveRequest(int socket, std::vector<std::string>& payload, int fds[3]) {
+        uint32_t size;
+
+        char control[CMSG_SPACE(sizeof(int) * PASSED_FDS)] = {};
+        iovec iov = { &size, sizeof(size) };
+
+        msghdr message        = {};
+        message.msg_iov        = &iov;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+
+        // whatever the request looks like, the descriptors it carried are ours
+        // now and must not outlive a rejected request
+        std::vector<int> receivedFds;
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                size_t start = receivedFds.size();
+
+                receivedFds.resize(start + count);
+                memcpy(receivedFds.data() + start, CMSG_DATA(header), count * sizeof(int));
+            }
+        }
+
+        if (received != sizeof(size) || receivedFds.size() != PASSED_FDS || size > MAX_REQUEST_SIZE) {
+            closeAll(receivedFds);
+            return false;
+        }
+
+        std::string data(size, '\0');
+        if (!ReadAll(socket, data.data(), data.size()) || !parsePayload(data, payload)) {
+            closeAll(receivedFds);
+            return false;
+        }
+
+        std::copy(receivedFds.begin(), receivedFds.end(), fds);
+        return true;
+    }
+
+    bool WriteAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+
+        while (size > 0) {
+            ssize_t written = write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+
+            bytes += written;
+            size -= written;
+        }
+
+        return true;
+    }
+
+    bool ReadAll(int fd, void* data, size_t size) {
+        char* bytes = static_cast<char*>(data);
+
+        while (size > 0) {
+            ssize_t count = read(fd, bytes, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+
+            bytes += count;
+            size -= count;
+        }
+
+        return true;
+    }
+
+}  // namespace optiz::server
+
+static bool parsePayload(const std::string& data, std::vector<std::string>& payload) {
+    payload.clear();
+
+    for (size_t start = 0; start < data.size();) {
+        size_t end = data.find('\0', start);
+        if (end == std::string::npos) {
+            return false;
+        }
+
+        payload.push_back(data.substr(start, end - start));
+        start = end + 1;
+    }
+
+    return true;
+}
+
+static void closeAll(const std::vector<int>& fds) {
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+#undef PASSED_FDS
+#undef MAX_REQUEST_SIZE
@@ -0,0 +1,261 @@
+#include "server/Server.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "server/Protocol.hpp"
+
+#define LISTEN_BACKLOG 16
+
+#define MAX_WARM_UP_NOTE 4096
+
+// How long a request's process waits for the client to send the request.
+#define REQUEST_TIMEOUT_SECONDS 10
+
+struct RunningRequest {
+    int m_Connection;
+    int m_WarmUpNote;  // read end of the pipe the request leaves its note in
+};
+
+// The requests still compiling, by the pid of their process.
+using RunningRequests = llvm::DenseMap<pid_t, RunningRequest>;
+
+static pid_t startRequest(int connection, const int serverFds[2], RunningRequests& running, optiz::server::CompileFunction compile);
+static void finishRequests(RunningRequests& running, optiz::server::WarmUpFunction warmUp);
+static int runRequest(int connection, int warmUpNote, optiz::server::CompileFunction compile);
+static int runCompilation(const std::vector<std::string>& payload, const int fds[3], int warmUpNote, optiz::server::CompileFunction compile);
+static std::string readWarmUpNote(int fd);
+
+namespace optiz::server {
+
+    int Serve(llvm::StringRef socketPath, CompileFunction compile, WarmUpFunction warmUp) {
+        sockaddr_un address = {};
+        address.sun_family  = AF_UNIX;
+
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            llvm::errs() << "optiz: socket path too long: " << socketPath << "\n";
+            return 1;
+        }
+        memcpy(address.sun_path, socketPath.data(), socketPath.size());
+
+        int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener < 0) {
+            perror("optiz: socket");
+            return 1;
+        }
+
+        // a stale socket from a previous server would make bind fail, anything
+        // else at the path is not ours to remove
+        struct stat status;
+        if (lstat(address.sun_path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+            unlink(address.sun_path);
+        }
+
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, LISTEN_BACKLOG) < 0) {
+            perror("optiz: cannot listen on the socket");
+            return 1;
+        }
+
+        // a client going away mid-request must not kill the server
+        signal(SIGPIPE, SIG_IGN);
+
+        // finished requests are noticed through a signalfd, so the server keeps
+        // accepting while earlier requests compile
+        sigset_t childSignals;
+        sigemptyset(&childSignals);
+        sigaddset(&childSignals, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &childSignals, nullptr);
+
+        int children = signalfd(-1, &childSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (children < 0) {
+            perror("optiz: signalfd");
+            return 1;
+        }
+
+        int serverFds[2] = { listener, children };
+        RunningRequests running;
+
+        while (true) {
+            pollfd events[2] = { { listener, POLLIN, 0 }, { children, POLLIN, 0 } };
+            if (poll(events, 2, -1) < 0) {
+                continue;
+            }
+
+            if (events[1].revents & POLLIN) {
+                signalfd_siginfo info;
+                while (read(children, &info, sizeof(info)) == sizeof(info)) {}
+
+                finishRequests(running, warmUp);
+            }
+
+            if (events[0].revents & POLLIN) {
+                int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+                if (connection < 0) {
+                    continue;
+                }
+
+                if (startRequest(connection, serverFds, running, compile) < 0) {
+                    close(connection);
+                }
+            }
+        }
+    }
+
+}  // namespace optiz::server
+
+// Forks a process off for the request and adds it to `running`, or answers
+// the request with a failure right away and returns -1. The request is read
+// in that process, so a slow or silent client never holds up the server.
+static pid_t startRequest(int connection, const int serverFds[2], RunningRequests& running, optiz::server::CompileFunction compile) {
+    int warmUpNote[2] = { -1, -1 };
+    pid_t pid         = pipe2(warmUpNote, O_CLOEXEC) == 0 ? fork() : -1;
+
+    if (pid == 0) {
+        close(serverFds[0]);
+        close(serverFds[1]);
+        close(warmUpNote[0]);
+        for (const auto& request : running) {
+            close(request.second.m_Connection);
+            close(request.second.m_WarmUpNote);
+        }
+
+        sigset_t childSignals;
+        sigemptyset(&childSignals);
+        sigaddset(&childSignals, SIGCHLD);
+        sigprocmask(SIG_UNBLOCK, &childSignals, nullptr);
+
+        exit(runRequest(connection, warmUpNote[1], compile));
+    }
+
+    close(warmUpNote[1]);
+
+    if (pid < 0) {
+        close(warmUpNote[0]);
+
+        int32_t exitCode = 1;
+        optiz::server::WriteAll(connection, &exitCode, sizeof(exitCode));
+        return -1;
+    }
+
+    running[pid] = RunningRequest{ connection, warmUpNote[0] };
+    return pid;
+}
+
+// Answers every request whose compilation has exited, then warms up with
+// their notes.
+static void finishRequests(RunningRequests& running, optiz::server::WarmUpFunction warmUp) {
+    std::vector<std::string> notes;
+    pid_t pid;
+    int status;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto request = running.find(pid);
+        if (request == running.end()) {
+            continue;
+        }
+
+        int32_t exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        optiz::server::WriteAll(request->second.m_Connection, &exitCode, sizeof(exitCode));
+        notes.push_back(readWarmUpNote(request->second.m_WarmUpNote));
+
+        close(request->second.m_Connection);
+        close(request->second.m_WarmUpNote);
+        running.erase(request);
+    }
+
+    for (const std::string& note : notes) {
+        if (!note.empty()) {
+            warmUp(note);
+        }
+    }
+}
+
+static int runRequest(int connection, int warmUpNote, optiz::server::CompileFunction compile) {
+    timeval timeout = { REQUEST_TIMEOUT_SECONDS, 0 };
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::vector<std::string> payload;
+    int fds[3];
+
+    bool received = optiz::server::ReceiveRequest(connection, payload, fds);
+    close(connection);
+
+    if (!received) {
+        return 1;
+    }
+
+    if (payload.size() < 2) {
+        for (int fd : fds) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    return runCompilation(payload, fds, warmUpNote, compile);
+}
+
+static int runCompilation(const std::vector<std::string>& payload, const int fds[3], int warmUpNote, optiz::server::CompileFunction compile) {
+    for (int i = 0; i < 3; i++) {
+        dup2(fds[i], i);
+    }
+
+    if (chdir(payload[0].c_str()) < 0) {
+        perror("optiz: cannot change to the client's working directory");
+        return 1;
+    }
+
+    std::vector<const char*> argv;
+    for (size_t i = 1; i < payload.size(); i++) {
+        argv.push_back(payload[i].c_str());
+    }
+
+    std::string note;
+    int exitCode = compile(argv.size(), argv.data(), note);
+
+    std::cout.flush();
+    llvm::outs().flush();
+    fflush(nullptr);
+
+    // the server only reads the note once the request has exited, so it has
+    // to fit into the pipe
+    if (note.size() <= MAX_WARM_UP_NOTE) {
+        optiz::server::WriteAll(warmUpNote, note.data(), note.size());
+    }
+
+    return exitCode;
+}
+
+static std::string readWarmUpNote(int fd) {
+    std::string note(MAX_WARM_UP_NOTE, '\0');
+    size_t size = 0;
+    ssize_t count;
+
+    while (size < note.size() && (count = read(fd, note.data() + size, note.size() - size)) != 0) {
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+        size += std::max<ssize_t>(count, 0);
+    }
+
+    note.resize(size);
+    return note;
+}
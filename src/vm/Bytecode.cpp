@@ -0,0 +1,40 @@
+#include "vm/Bytecode.hpp"
+
+namespace optiz::vm {
+
+    std::ostream& operator<<(std::ostream& out, OpCode opCode) {
+        switch (opCode) {
+            case OpCode::LoadConst: return out << "LOADCONST";
+            case OpCode::Neg: return out << "NEG";
+            case OpCode::Add: return out << "ADD";
+            case OpCode::Sub: return out << "SUB";
+            case OpCode::Mul: return out << "MUL";
+            case OpCode::Div: return out << "DIV";
+            case OpCode::Ret: return out << "RET";
+        }
+
+        return out << "UNKNOWN(" << static_cast<int>(opCode) << ')';
+    }
+
+    std::ostream& operator<<(std::ostream& out, const BytecodeModule& module) {
+        for (const BytecodeFunction& function : module.m_Functions) {
+            out << function.m_Name << " (" << function.m_RegisterCount << " registers):\n";
+
+            for (const Instruction& instruction : function.m_Code) {
+                out << "    " << instruction.m_OpCode << " r" << instruction.m_Dst;
+
+                switch (instruction.m_OpCode) {
+                    case OpCode::LoadConst: out << ", " << function.m_Constants[instruction.m_LHS]; break;
+                    case OpCode::Neg: out << ", r" << instruction.m_LHS; break;
+                    case OpCode::Ret: break;
+                    default: out << ", r" << instruction.m_LHS << ", r" << instruction.m_RHS; break;
+                }
+
+                out << '\n';
+            }
+        }
+
+        return out;
+    }
+
+}  // namespace optiz::vm
@@ -0,0 +1,99 @@
+#include "vm/BytecodeCompiler.hpp"
+
+#include <llvm/Support/ErrorHandling.h>
+
+#include <limits>
+
+#include "cg/CodeGen.hpp"
+
+namespace optiz::vm {
+
+    BytecodeCompiler::BytecodeCompiler() : m_Function(nullptr), m_NextRegister(0), m_Result(0) {}
+
+    BytecodeModule BytecodeCompiler::TakeModule() {
+        return std::move(m_Module);
+    }
+
+    void BytecodeCompiler::Visit(const fe::UnaryExprAST& node) {
+        node.GetExpr()->accept(*this);
+
+        switch (node.getOperation()) {
+            case fe::TokenType::Plus: break;
+            case fe::TokenType::Minus: Emit(OpCode::Neg, m_Result, m_Result); break;
+            default: llvm_unreachable("unsupported unary operation");
+        }
+    }
+
+    void BytecodeCompiler::Visit(const fe::BinaryExprAST& node) {
+        node.GetLHS()->accept(*this);
+        uint16_t lhs = m_Result;
+        node.GetRHS()->accept(*this);
+        uint16_t rhs = m_Result;
+
+        switch (node.GetOperation()) {
+            case fe::TokenType::Plus: Emit(OpCode::Add, lhs, lhs, rhs); break;
+            case fe::TokenType::Minus: Emit(OpCode::Sub, lhs, lhs, rhs); break;
+            case fe::TokenType::Star: Emit(OpCode::Mul, lhs, lhs, rhs); break;
+            case fe::TokenType::Slash:
+                m_Function->m_Locations.emplace_back(m_Function->m_Code.size(), node.GetStartLocation());
+                Emit(OpCode::Div, lhs, lhs, rhs);
+                break;
+            default: llvm_unreachable("unsupported binary operation");
+        }
+
+        // the right operand's register (and everything above it) is free again
+        m_NextRegister = rhs;
+        m_Result       = lhs;
+    }
+
+    void BytecodeCompiler::Visit(const fe::NumberExprAST& node) {
+        if (m_Function->m_Constants.size() > std::numeric_limits<uint16_t>::max()) {
+            llvm::report_fatal_error(llvm::Twine("too many constants in ") + m_Function->m_Name);
+        }
+
+        uint16_t constant = m_Function->m_Constants.size();
+        m_Function->m_Constants.push_back(node.GetValue());
+
+        m_Result = AllocateRegister();
+        Emit(OpCode::LoadConst, m_Result, constant);
+    }
+
+    void BytecodeCompiler::Visit(const fe::ProgramAST& node) {
+        const auto& expressions = node.GetExpressions();
+        m_Module.m_Functions.resize(expressions.size());
+
+        for (size_t i = 0; i < expressions.size(); i++) {
+            m_Function                  = &m_Module.m_Functions[i];
+            m_Function->m_Name          = cg::CodeGen::GetUnitName(i);
+            m_Function->m_RegisterCount = 0;
+            m_NextRegister              = 0;
+
+            expressions[i]->accept(*this);
+            Emit(OpCode::Ret, m_Result);
+        }
+
+        m_Function = nullptr;
+    }
+
+    void BytecodeCompiler::Visit(const fe::ErrorAST& node) {
+        llvm_unreachable("cannot compile an erroneous AST");
+    }
+
+    uint16_t BytecodeCompiler::AllocateRegister() {
+        if (m_NextRegister == std::numeric_limits<uint16_t>::max()) {
+            llvm::report_fatal_error(llvm::Twine("expression too deep for the register file in ") + m_Function->m_Name);
+        }
+
+        uint16_t reg = m_NextRegister++;
+        if (m_NextRegister > m_Function->m_RegisterCount) {
+            m_Function->m_RegisterCount = m_NextRegister;
+        }
+
+        return reg;
+    }
+
+    void BytecodeCompiler::Emit(OpCode opCode, uint16_t dst, uint16_t lhs, uint16_t rhs) {
+        m_Function->m_Code.push_back(Instruction{ opCode, dst, lhs, rhs });
+    }
+
+}  // namespace optiz::vm
@@ -0,0 +1,169 @@
+#include "vm/Interpreter.hpp"
+
+#include <llvm/ADT/SmallVector.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <limits>
+
+#include "cg/CodeGen.hpp"
+
+// Threaded dispatch jumps straight from one handler to the next through a table
+// of label addresses, which needs the GNU "labels as values" extension.
+#if defined(__GNUC__)
+#define OPTIZ_THREADED_DISPATCH
+#endif
+
+#ifdef OPTIZ_THREADED_DISPATCH
+#define VM_DISPATCH() goto* s_DispatchTable[static_cast<size_t>(ip->m_OpCode)];
+#define VM_CASE(op)   L_##op:
+#define VM_NEXT() \
+    ++ip;         \
+    VM_DISPATCH()
+#else
+#define VM_DISPATCH() \
+    dispatch:         \
+    switch (ip->m_OpCode)
+#define VM_CASE(op) case OpCode::op:
+#define VM_NEXT() \
+    ++ip;         \
+    goto dispatch;
+#endif
+
+static int32_t wrappingAdd(int32_t lhs, int32_t rhs);
+static int32_t wrappingSub(int32_t lhs, int32_t rhs);
+static int32_t wrappingMul(int32_t lhs, int32_t rhs);
+static llvm::Error checkFailure(const optiz::vm::BytecodeFunction& function, uint32_t instruction, const std::string& message);
+
+namespace optiz::vm {
+
+    Interpreter::Interpreter(const BytecodeModule& module, std::unique_ptr<JITPromoter> promoter, uint32_t promotionThreshold)
+        : m_Module(module),
+          m_Promoter(std::move(promoter)),
+          m_CallCounts(module.m_Functions.size(), 0),
+          m_PromotionThreshold(promotionThreshold),
+          m_InterpretedCalls(0),
+          m_NativeCalls(0) {}
+
+    llvm::Expected<int32_t> Interpreter::Call(size_t index) {
+        if (m_Promoter) {
+            if (NativeFunction native = m_Promoter->GetNativeFunction(index)) {
+                m_NativeCalls++;
+                return native();
+            }
+
+            if (m_PromotionThreshold != 0 && ++m_CallCounts[index] == m_PromotionThreshold) {
+                m_Promoter->Request(index);
+            }
+        }
+
+        m_InterpretedCalls++;
+        return Execute(m_Module.m_Functions[index]);
+    }
+
+    llvm::Error Interpreter::RunMain(uint32_t runs) {
+        for (uint32_t run = 0; run < runs; run++) {
+            for (size_t i = 0; i < m_Module.m_Functions.size(); i++) {
+                auto result = Call(i);
+                if (!result) {
+                    return result.takeError();
+                }
+
+                printf("%d\n", *result);
+            }
+        }
+
+        return llvm::Error::success();
+    }
+
+    uint64_t Interpreter::GetInterpretedCallCount() const {
+        return m_InterpretedCalls;
+    }
+
+    uint64_t Interpreter::GetNativeCallCount() const {
+        return m_NativeCalls;
+    }
+
+    llvm::Expected<int32_t> Interpreter::Execute(const BytecodeFunction& function) {
+#ifdef OPTIZ_THREADED_DISPATCH
+        // must follow the declaration order of OpCode
+        static void* s_DispatchTable[] = {
+            &&L_LoadConst, &&L_Neg, &&L_Add, &&L_Sub, &&L_Mul, &&L_Div, &&L_Ret
+        };
+#endif
+
+        llvm::SmallVector<int32_t, 16> registers(function.m_RegisterCount);
+        int32_t* r                = registers.data();
+        const int32_t* constants  = function.m_Constants.data();
+        const Instruction* ip     = function.m_Code.data();
+
+        VM_DISPATCH() {
+            VM_CASE(LoadConst) {
+                r[ip->m_Dst] = constants[ip->m_LHS];
+                VM_NEXT()
+            }
+            VM_CASE(Neg) {
+                r[ip->m_Dst] = wrappingSub(0, r[ip->m_LHS]);
+                VM_NEXT()
+            }
+            VM_CASE(Add) {
+                r[ip->m_Dst] = wrappingAdd(r[ip->m_LHS], r[ip->m_RHS]);
+                VM_NEXT()
+            }
+            VM_CASE(Sub) {
+                r[ip->m_Dst] = wrappingSub(r[ip->m_LHS], r[ip->m_RHS]);
+                VM_NEXT()
+            }
+            VM_CASE(Mul) {
+                r[ip->m_Dst] = wrappingMul(r[ip->m_LHS], r[ip->m_RHS]);
+                VM_NEXT()
+            }
+            VM_CASE(Div) {
+                int32_t lhs = r[ip->m_LHS];
+                int32_t rhs = r[ip->m_RHS];
+
+                if (rhs == 0) {
+                    return checkFailure(function, ip - function.m_Code.data(), "division by zero");
+                }
+                if (lhs == std::numeric_limits<int32_t>::min() && rhs == -1) {
+                    return checkFailure(function, ip - function.m_Code.data(), "division overflow");
+                }
+
+                r[ip->m_Dst] = lhs / rhs;
+                VM_NEXT()
+            }
+            VM_CASE(Ret) {
+                return r[ip->m_Dst];
+            }
+        }
+
+        llvm_unreachable("bytecode function does not end with RET");
+    }
+
+}  // namespace optiz::vm
+
+#undef VM_DISPATCH
+#undef VM_CASE
+#undef VM_NEXT
+
+static int32_t wrappingAdd(int32_t lhs, int32_t rhs) {
+    return static_cast<int32_t>(static_cast<uint32_t>(lhs) + static_cast<uint32_t>(rhs));
+}
+
+static int32_t wrappingSub(int32_t lhs, int32_t rhs) {
+    return static_cast<int32_t>(static_cast<uint32_t>(lhs) - static_cast<uint32_t>(rhs));
+}
+
+static int32_t wrappingMul(int32_t lhs, int32_t rhs) {
+    return static_cast<int32_t>(static_cast<uint32_t>(lhs) * static_cast<uint32_t>(rhs));
+}
+
+// Reported like the run-time checks of the generated code.
+static llvm::Error checkFailure(const optiz::vm::BytecodeFunction& function, uint32_t instruction, const std::string& message) {
+    auto location = std::find_if(function.m_Locations.begin(), function.m_Locations.end(),
+                                 [instruction](const auto& location) { return location.first == instruction; });
+    assert(location != function.m_Locations.end() && "failing instruction without a location");
+
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), optiz::cg::CodeGen::GetCheckFailureReport(location->second, message));
+}
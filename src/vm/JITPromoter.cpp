@@ -0,0 +1,102 @@
+#include "vm/JITPromoter.hpp"
+
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "cg/CodeGen.hpp"
+
+namespace optiz::vm {
+
+    JITPromoter::JITPromoter(const fe::ProgramAST& program, cg::BackendOptions options)
+        : m_Program(program), m_Options(std::move(options)), m_NativeFunctions(program.GetExpressions().size()), m_Stopping(false) {}
+
+    JITPromoter::~JITPromoter() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_one();
+
+        if (m_Worker.joinable()) {
+            m_Worker.join();
+        }
+    }
+
+    void JITPromoter::Request(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Queue.push_back(index);
+
+            if (!m_Worker.joinable()) {
+                m_Worker = std::thread(&JITPromoter::Work, this);
+            }
+        }
+        m_Condition.notify_one();
+    }
+
+    void JITPromoter::Work() {
+        while (true) {
+            size_t index;
+
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+
+                if (m_Stopping) {
+                    return;
+                }
+
+                index = m_Queue.front();
+                m_Queue.pop_front();
+            }
+
+            auto function = Compile(index);
+            if (!function) {
+                // the unit simply stays in the interpreter
+                llvm::logAllUnhandledErrors(function.takeError(), llvm::errs(), "optiz: cannot promote unit: ");
+                continue;
+            }
+
+            m_NativeFunctions[index].store(*function, std::memory_order_release);
+        }
+    }
+
+    llvm::Expected<NativeFunction> JITPromoter::Compile(size_t index) {
+        if (!m_JIT) {
+            auto jit = jit::JIT::Create();
+            if (!jit) {
+                return jit.takeError();
+            }
+            m_JIT = std::move(*jit);
+
+            auto targetMachine = cg::CreateTargetMachine(m_Options);
+            if (!targetMachine) {
+                return targetMachine.takeError();
+            }
+            m_TargetMachine = std::move(*targetMachine);
+        }
+
+        auto context = std::make_unique<llvm::LLVMContext>();
+        auto module  = std::make_unique<llvm::Module>(cg::CodeGen::GetUnitName(index), *context);
+        module->setTargetTriple(m_TargetMachine->getTargetTriple().str());
+        module->setDataLayout(m_TargetMachine->createDataLayout());
+
+        cg::CodeGen codeGen(*module);
+        llvm::Function* unit = codeGen.GenerateUnit(*m_Program.GetExpressions()[index], index);
+        unit->setLinkage(llvm::Function::ExternalLinkage);
+
+        cg::OptimizeModule(*module, *m_TargetMachine, m_Options.m_OptimizationLevel);
+
+        if (auto error = m_JIT->AddModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+            return error;
+        }
+
+        auto address = m_JIT->Lookup(cg::CodeGen::GetUnitName(index));
+        if (!address) {
+            return address.takeError();
+        }
+
+        return reinterpret_cast<NativeFunction>(*address);
+    }
+
+}  // namespace optiz::vm
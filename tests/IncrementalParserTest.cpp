@@ -0,0 +1,186 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "fe/AST.hpp"
+#include "fe/IncrementalParser.hpp"
+#include "fe/Parser.hpp"
+
+using namespace optiz::fe;
+
+static int s_Failures = 0;
+
+#define CHECK(condition, message)                                                         \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": FAIL: " << message << std::endl; \
+            s_Failures++;                                                                 \
+        }                                                                                 \
+    } while (false)
+
+// Prints an AST with every location, so two ASTs print the same only if they
+// are the same tree parsed from the same places.
+class ASTDumper : public ASTVisitor {
+    std::ostringstream m_Out;
+
+public:
+    std::string Dump(const GenericASTNode& node) {
+        node.accept(*this);
+        return m_Out.str();
+    }
+
+private:
+    void Visit(const UnaryExprAST& node) override {
+        Open("unary", node);
+        m_Out << static_cast<int>(node.getOperation()) << " ";
+        node.GetExpr()->accept(*this);
+        m_Out << ")";
+    }
+
+    void Visit(const BinaryExprAST& node) override {
+        Open("binary", node);
+        m_Out << static_cast<int>(node.GetOperation()) << " ";
+        node.GetLHS()->accept(*this);
+        node.GetRHS()->accept(*this);
+        m_Out << ")";
+    }
+
+    void Visit(const NumberExprAST& node) override {
+        Open("number", node);
+        m_Out << node.GetValue() << ")";
+    }
+
+    void Visit(const ProgramAST& node) override {
+        Open("program", node);
+        for (const auto& expression : node.GetExpressions()) {
+            expression->accept(*this);
+        }
+        m_Out << ")";
+    }
+
+    void Visit(const ErrorAST& node) override {
+        m_Out << "(error)";
+    }
+
+    void Open(const char* kind, const GenericASTNode& node) {
+        const SrcLocation& start = node.GetStartLocation();
+        const SrcLocation& end   = node.GetEndLocation();
+
+        m_Out << "(" << kind << " " << start.m_Line << ":" << start.m_Column << "@" << start.m_Offset << "-" << end.m_Line << ":"
+              << end.m_Column << "@" << end.m_Offset << " ";
+    }
+};
+
+static std::string dumpFullParse(const std::string& text, bool& hasDiagnostics) {
+    DiagnosticEngine diagnosticEngine(0);
+    Parser parser(text, "test.optiz", diagnosticEngine);
+    std::unique_ptr<GenericASTNode> program = parser.ParseProgram();
+
+    hasDiagnostics = diagnosticEngine.HasReports();
+    return ASTDumper().Dump(*program);
+}
+
+static void checkAgainstFullParse(const IncrementalParser& session, const std::string& context) {
+    bool hasDiagnostics;
+    std::string expected = dumpFullParse(session.GetText(), hasDiagnostics);
+    std::string actual   = ASTDumper().Dump(*session.BuildProgram());
+
+    CHECK(actual == expected, context << "\n  text:        " << session.GetText() << "\n  incremental: " << actual
+                                      << "\n  full parse:  " << expected);
+    CHECK(session.HasDiagnostics() == hasDiagnostics, context << ": diagnostics differ for: " << session.GetText());
+}
+
+// Random edits, many of them breaking statements or joining and splitting
+// them, must always leave the same AST as parsing the text from scratch.
+static void testRandomEdits() {
+    const char* snippets[] = { "", "1", "23", "+", "-", "*", "/", "(", ")", ";", " ", "\n", "4 * (5 + 6);", "\n7;\n", "$" };
+
+    std::mt19937 random(42);
+
+    for (int round = 0; round < 20; round++) {
+        IncrementalParser session("1 + 2;\n3 * (4 - 5);\n\n  -6 / 2;\n7;", "test.optiz");
+        checkAgainstFullParse(session, "initial parse");
+
+        for (int i = 0; i < 200; i++) {
+            const std::string& text = session.GetText();
+            uint offset             = random() % (text.size() + 1);
+            uint length             = std::min<uint>(random() % 4, text.size() - offset);
+            std::string replacement = snippets[random() % std::size(snippets)];
+
+            session.ApplyEdit(TextEdit{ offset, length, replacement });
+
+            std::ostringstream context;
+            context << "round " << round << ", edit " << i << " (" << offset << ", " << length << ", '" << replacement << "')";
+            checkAgainstFullParse(session, context.str());
+        }
+    }
+}
+
+// An edit inside one statement of a long file re-parses that statement only.
+static void testEditCostIsLocal() {
+    std::string text;
+    for (int i = 0; i < 5000; i++) {
+        text += std::to_string(i) + " + 1;\n";
+    }
+
+    IncrementalParser session(text, "test.optiz");
+    CHECK(session.GetStatementCount() == 5000, "expected 5000 statements, got " << session.GetStatementCount());
+
+    uint offset = session.GetText().find("2500 + 1;");
+    session.ApplyEdit(TextEdit{ offset, 4, "(2500 * 2)" });
+
+    CHECK(session.GetReparsedCount() == 1, "expected 1 re-parsed statement, got " << session.GetReparsedCount());
+    checkAgainstFullParse(session, "local edit");
+}
+
+// Replacing the whole text re-parses only the statements between the common
+// prefix and suffix of the old and the new text.
+static void testReplaceText() {
+    IncrementalParser session("1 + 2;\n3 * 4;\n5 - 6;\n", "test.optiz");
+
+    session.ReplaceText("1 + 2;\n\n3 * (4 + 1);\n5 - 6;\n");
+    CHECK(session.GetReparsedCount() == 1, "expected 1 re-parsed statement, got " << session.GetReparsedCount());
+    checkAgainstFullParse(session, "replaced text");
+
+    session.ReplaceText(session.GetText());
+    CHECK(session.GetReparsedCount() == 0, "an unchanged text re-parsed " << session.GetReparsedCount() << " statements");
+
+    session.ReplaceText("7;");
+    checkAgainstFullParse(session, "replaced everything");
+}
+
+// The errors of one edit must not count against the next, nor abort the
+// session once more than a parse's worth of errors came together.
+static void testErrorsDoNotAccumulate() {
+    IncrementalParser session("1;", "test.optiz");
+
+    for (int i = 0; i < 100; i++) {
+        session.ApplyEdit(TextEdit{ 0, static_cast<uint>(session.GetText().size()), "1 +;" });
+        CHECK(session.GetDiagnostics().HasErrors(), "edit " << i << " should report an error");
+    }
+
+    std::string broken;
+    for (int i = 0; i < 50; i++) {
+        broken += "1 +;\n";
+    }
+    session.ApplyEdit(TextEdit{ 0, static_cast<uint>(session.GetText().size()), broken });
+    CHECK(session.GetDiagnostics().GetReports().size() == 50, "expected 50 errors, got " << session.GetDiagnostics().GetReports().size());
+
+    session.ApplyEdit(TextEdit{ 0, static_cast<uint>(session.GetText().size()), "1;" });
+    CHECK(!session.GetDiagnostics().HasErrors() && !session.HasDiagnostics(), "a fixed buffer should have no errors");
+}
+
+int main() {
+    testRandomEdits();
+    testEditCostIsLocal();
+    testReplaceText();
+    testErrorsDoNotAccumulate();
+
+    if (s_Failures != 0) {
+        std::cerr << s_Failures << " checks failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,7 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '6 * 7;\n' > bench.optiz
+
+# no mean of nothing, and no standard deviation of a single sample
+expect_error "--bench-samples must be at least 2" --bench --bench-samples=0 bench.optiz
+expect_error "--bench-samples must be at least 2" --bench --bench-samples=1 bench.optiz
@@ -0,0 +1,34 @@
+. "$(dirname "$0")/lib.sh"
+
+rm -rf cache
+
+# expect_cache_stats <stats> <file> <optiz arguments...>
+expect_cache_stats() {
+    stats=$1
+    shift
+
+    "$OPTIZ" -c --cache-dir=cache --cache-stats "$@" -o out.o 2> stats.txt || fail "optiz $* exited with $?"
+    [ "$(cat stats.txt)" = "cache: $stats" ] || fail "optiz $*: expected '$stats', got '$(cat stats.txt)'"
+}
+
+# moved code is reused as long as its object does not record where it was
+printf '1+2;\n3*4;\n' > moved.optiz
+expect_cache_stats "0 hits, 2 misses" moved.optiz
+printf '\n\n\n1+2;\n3*4;\n' > moved.optiz
+expect_cache_stats "2 hits, 0 misses" moved.optiz
+
+# the debug info records every location
+printf '1+2;\n3*4;\n' > debug.optiz
+expect_cache_stats "0 hits, 2 misses" -g debug.optiz
+expect_cache_stats "2 hits, 0 misses" -g debug.optiz
+printf '\n\n\n1+2;\n3*4;\n' > debug.optiz
+expect_cache_stats "0 hits, 2 misses" -g debug.optiz
+
+# and a division check reports its location
+printf '1/(2-2);\n' > division.optiz
+expect_cache_stats "0 hits, 1 misses" division.optiz
+printf '\n1/(2-2);\n' > division.optiz
+expect_cache_stats "0 hits, 1 misses" division.optiz
+
+# the cache holds objects, not ThinLTO bitcode
+expect_error "--cache-dir cannot be combined with -flto=thin" -c -flto=thin --cache-dir=cache division.optiz -o out.o
@@ -0,0 +1,30 @@
+. "$(dirname "$0")/lib.sh"
+
+rm -rf cache
+
+# expect_cache_stats <stats> <optiz arguments...>
+expect_cache_stats() {
+    stats=$1
+    shift
+
+    "$OPTIZ" -c --cache-dir=cache --cache-stats "$@" -o out.o 2> stats.txt || fail "optiz $* exited with $?"
+    [ "$(cat stats.txt)" = "cache: $stats" ] || fail "optiz $*: expected '$stats', got '$(cat stats.txt)'"
+}
+
+# expect_run <output>
+expect_run() {
+    "${CC:-cc}" out.o -o out || fail "cannot link out.o"
+    [ "$(./out)" = "$(printf -- "$1")" ] || fail "expected '$1', got '$(./out)'"
+}
+
+# units are keyed by their code, not by their position
+printf '1+2;\n3*4;\n' > program.optiz
+expect_cache_stats "0 hits, 2 misses" program.optiz
+printf '5-6;\n1+2;\n3*4;\n' > program.optiz
+expect_cache_stats "2 hits, 1 misses" program.optiz
+expect_run '-1\n3\n12'
+
+# identical units share one object
+printf '1+2;\n7;\n1+2;\n' > program.optiz
+expect_cache_stats "1 hits, 1 misses" program.optiz
+expect_run '3\n7\n3'
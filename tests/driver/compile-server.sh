@@ -0,0 +1,78 @@
+. "$(dirname "$0")/lib.sh"
+
+rm -f server.sock
+
+# only a stale socket may be replaced
+echo "not a socket" > server.sock
+if "$OPTIZ" --serve=server.sock 2> /dev/null; then
+    fail "the server replaced a regular file"
+fi
+[ "$(cat server.sock)" = "not a socket" ] || fail "the server overwrote a regular file"
+rm server.sock
+
+"$OPTIZ" --serve=server.sock &
+server=$!
+trap 'kill $server' EXIT
+
+while [ ! -S server.sock ]; do
+    sleep 0.1
+done
+
+printf '1 + 2;\n6 * 7;\n' > good.optiz
+printf '1 +;\n' > bad.optiz
+
+# concurrent requests are all answered with their own exit code
+for i in 1 2 3 4; do
+    "$OPTIZ_CLIENT" server.sock --run good.optiz > good$i.txt &
+done
+if "$OPTIZ_CLIENT" server.sock --run bad.optiz 2> /dev/null; then
+    fail "a failing request succeeded"
+fi
+wait %2 %3 %4 %5
+
+for i in 1 2 3 4; do
+    [ "$(cat good$i.txt)" = "$(printf '3\n42')" ] || fail "request $i printed '$(cat good$i.txt)'"
+done
+
+# a client that never sends its request only holds up its own request, and a
+# request claiming a huge payload is refused without reading it
+if command -v python3 > /dev/null; then
+    rm -f silent.txt
+    python3 -c 'import socket, sys, time; s = socket.socket(socket.AF_UNIX); s.connect(sys.argv[1]); print(flush=True); time.sleep(30)' \
+        server.sock > silent.txt &
+    silent=$!
+
+    while [ ! -s silent.txt ]; do
+        sleep 0.1
+    done
+
+    output=$(timeout 10 "$OPTIZ_CLIENT" server.sock --run good.optiz) || fail "a silent client held up the server"
+    [ "$output" = "$(printf '3\n42')" ] || fail "the request next to a silent client printed '$output'"
+    kill $silent
+
+    exitCode=$(timeout 10 python3 -c '
+import socket, struct, sys
+s = socket.socket(socket.AF_UNIX)
+s.connect(sys.argv[1])
+socket.send_fds(s, [struct.pack("I", 0xffffffff)], [0, 1, 2])
+print(struct.unpack("i", s.recv(4))[0])' server.sock) || fail "no answer to an oversized request"
+    [ "$exitCode" = 1 ] || fail "an oversized request exited with $exitCode"
+fi
+
+# a stale socket left by the server is replaced
+kill $server
+wait $server || true
+trap - EXIT
+
+"$OPTIZ" --serve=server.sock &
+server=$!
+trap 'kill $server' EXIT
+
+# the old socket file is still there, so wait for an answer instead
+for attempt in $(seq 50); do
+    if output=$("$OPTIZ_CLIENT" server.sock --run good.optiz 2> /dev/null); then
+        break
+    fi
+    sleep 0.1
+done
+[ "$output" = "$(printf '3\n42')" ] || fail "the restarted server did not answer"
@@ -0,0 +1,14 @@
+. "$(dirname "$0")/lib.sh"
+
+# 2 * 3, + 4 and 1 - 1 fold, * 1, + 0 and the double negation go away
+printf '2 * 3 + 4;\n-(-(7 / (1 - 1))) * 1 + 0;\n' > fold.optiz
+
+"$OPTIZ" --fold-report --emit-llvm fold.optiz > /dev/null 2> report.txt || fail "optiz --fold-report exited with $?"
+[ "$(cat report.txt)" = "fold: 3 nodes folded to constants, 4 nodes removed by identities" ] || fail "unexpected report: $(cat report.txt)"
+
+# the rewritten tree still computes the same
+printf '2 * 3 + 4;\n-(-(7 / (2 - 1))) * 1 + 0;\n' > fold.optiz
+expect_output "10
+7" --run fold.optiz
+expect_output "10
+7" --run --fold-constants=false fold.optiz
@@ -0,0 +1,11 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '2147483647;\n-2147483647 - 1;\n' > limits.optiz
+expect_output "2147483647
+-2147483648" --run limits.optiz
+
+printf '1;\n99999999999;\n' > overflow.optiz
+expect_error "Integer literal '99999999999' does not fit in 32 bits" --run overflow.optiz
+
+printf '1.5;\n' > decimal.optiz
+expect_error "Expected an integer, found '1.5'" --run decimal.optiz
@@ -0,0 +1,25 @@
+. "$(dirname "$0")/lib.sh"
+
+# both tiers print the same results and fail the same way
+for program in '1;\n7 / (2 - 2);\n3;\n' '-2147483647 - 1;\n(-2147483647 - 1) / -1;\n' '84 / 2;\n-7 / 2;\n'; do
+    printf -- "$program" > tiers.optiz
+
+    "$OPTIZ" --run tiers.optiz > jit.out 2> jit.err && jit=0 || jit=$?
+    "$OPTIZ" --interpret tiers.optiz > interpreter.out 2> interpreter.err && interpreter=0 || interpreter=$?
+
+    [ $jit = $interpreter ] || fail "exit code $interpreter in the interpreter and $jit in the JIT for '$program'"
+    cmp -s jit.out interpreter.out || fail "different results for '$program'"
+    cmp -s jit.err interpreter.err || fail "different errors for '$program': $(cat interpreter.err) and $(cat jit.err)"
+done
+
+# hot units are promoted, optimized or not, and give the interpreter's results
+printf '6 * 7;\n100 / (1 + 3);\n' > hot.optiz
+
+expected=$("$OPTIZ" --interpret --interpret-runs=1000000 --jit-threshold=0 hot.optiz | cksum)
+
+for level in -O0 -O3; do
+    actual=$("$OPTIZ" --interpret --interpret-runs=1000000 --jit-threshold=10 --jit-timings $level hot.optiz 2> timings.txt | cksum)
+
+    [ "$actual" = "$expected" ] || fail "units promoted with $level printed different results"
+    grep -q "native: [1-9]" timings.txt || fail "no unit was promoted with $level: $(cat timings.txt)"
+done
@@ -0,0 +1,27 @@
+# Sourced by the driver tests.
+set -eu
+
+fail() {
+    echo "FAIL: $*" >&2
+    exit 1
+}
+
+# expect_output <expected> <optiz arguments...>
+expect_output() {
+    expected=$1
+    shift
+
+    actual=$("$OPTIZ" "$@") || fail "optiz $* exited with $?"
+    [ "$actual" = "$expected" ] || fail "optiz $*: expected '$expected', got '$actual'"
+}
+
+# expect_error <message> <optiz arguments...>
+expect_error() {
+    message=$1
+    shift
+
+    if "$OPTIZ" "$@" > /dev/null 2> stderr.txt; then
+        fail "optiz $* succeeded, expected '$message'"
+    fi
+    grep -qF -- "$message" stderr.txt || fail "optiz $*: expected '$message' in: $(cat stderr.txt)"
+}
@@ -0,0 +1,11 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '6 * 7;\n' > profile.optiz
+
+# an --instrument build that cannot write its profile says so at exit
+"$OPTIZ" -c --instrument --profile-output=missing/profile.txt profile.optiz -o profile.o || fail "optiz -c --instrument exited with $?"
+"${CC:-cc}" profile.o -o profile || fail "cannot link the instrumented program"
+
+./profile > stdout.txt 2> stderr.txt || fail "the instrumented program exited with $?"
+[ "$(cat stdout.txt)" = "42" ] || fail "the instrumented program printed '$(cat stdout.txt)'"
+grep -qF "optiz: cannot write profile 'missing/profile.txt'" stderr.txt || fail "no error for the unwritable profile: $(cat stderr.txt)"
@@ -0,0 +1,12 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '1 + 2;\n' > remarks.optiz
+
+# --run never optimizes, so it would have no remarks to report
+expect_error "optimization remarks need -c or --bench" --run -O2 --Rpass=.* --remarks-file=remarks.yaml remarks.optiz
+[ ! -e remarks.yaml ] || fail "a rejected --run left a remarks file"
+
+# remarks are diagnostics, on stderr like the others
+"$OPTIZ" -c -O2 --fold-constants=false --Rpass=inline remarks.optiz -o remarks.o > stdout.txt 2> stderr.txt || fail "optiz -c exited with $?"
+[ ! -s stdout.txt ] || fail "remarks on stdout: $(cat stdout.txt)"
+grep -qF "inlined into 'main'" stderr.txt || fail "no inlining remark in: $(cat stderr.txt)"
@@ -0,0 +1,11 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '6 * 7;\n' > scopes.optiz
+
+# a program that cannot write its --scope-report says so at exit
+"$OPTIZ" -c --instrument-scopes --scope-report=missing/scopes.json scopes.optiz -o scopes.o || fail "optiz -c --instrument-scopes exited with $?"
+"${CC:-cc}" scopes.o -o scopes || fail "cannot link the instrumented program"
+
+./scopes > stdout.txt 2> stderr.txt || fail "the instrumented program exited with $?"
+[ "$(cat stdout.txt)" = "42" ] || fail "the instrumented program printed '$(cat stdout.txt)'"
+grep -qF "optiz: cannot write scope report 'missing/scopes.json'" stderr.txt || fail "no error for the unwritable report: $(cat stderr.txt)"
@@ -0,0 +1,33 @@
+. "$(dirname "$0")/lib.sh"
+
+rm -f server.sock
+
+"$OPTIZ" --serve=server.sock &
+server=$!
+trap 'kill $server' EXIT
+
+while [ ! -S server.sock ]; do
+    sleep 0.1
+done
+
+# the server re-parses only what changed since the last request on a file,
+# which must compile to exactly what a fresh compiler makes of it
+check() {
+    printf "$1" > edited.optiz
+
+    "$OPTIZ" -g --emit-llvm edited.optiz > expected.ll 2> expected.err && expected=0 || expected=$?
+    "$OPTIZ_CLIENT" server.sock -g --emit-llvm edited.optiz > actual.ll 2> actual.err && actual=0 || actual=$?
+
+    [ $actual = $expected ] || fail "exit code $actual instead of $expected for '$1'"
+    cmp -s actual.ll expected.ll || fail "different IR for '$1'"
+    cmp -s actual.err expected.err || fail "different diagnostics for '$1'"
+}
+
+check '1 + 2;\n6 * 7;\n'
+check '1 + 2;\n\n\n6 * 7;\n'
+check '1 + 2;\n\n\n6 * (7 - 1);\n8;\n'
+check '1 +;\n\n\n6 * (7 - 1);\n8;\n'
+check '1 + 3;\n\n\n6 * (7 - 1);\n8;\n'
+check '8;\n'
+check ''
+check '4 / 2;\n1 + 2;\n'
@@ -0,0 +1,9 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '6 * 7;\n' > clones.optiz
+
+# only -c builds the resolver that picks a clone
+for action in --emit-llvm --run --bench --interpret; do
+    expect_error "--target-clones can only be used with -c" $action --target-clones=avx2,default clones.optiz
+done
+expect_error "--target-clones cannot be combined with -j" -c -j2 --target-clones=avx2,default clones.optiz -o clones.o
@@ -0,0 +1,9 @@
+. "$(dirname "$0")/lib.sh"
+
+printf '6 * 7;\n' > thin.optiz
+
+"$OPTIZ" -c -flto=thin thin.optiz -o thin.o || fail "optiz -c -flto=thin exited with $?"
+[ "$(head -c 2 thin.o)" = "BC" ] || fail "-flto=thin did not emit bitcode"
+
+# the bitcode is a single module, it cannot be split across threads
+expect_error "-j cannot be combined with -flto=thin" -c -flto=thin -j2 thin.optiz -o thin.o